@@ -16,6 +16,7 @@
 #ifdef CONFIG_SMP
 #define ARMADA_380_MAX_CPUS 2
 extern struct smp_operations armada_380_smp_ops;
+void armada_38x_mpic_msi_cpu_init(void);
 #endif
 
 #define IRQ_PRIV_MPIC_PPI_IRQ 31
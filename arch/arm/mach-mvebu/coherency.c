@@ -119,6 +119,45 @@ static void mvebu_hwcc_dma_sync(struct device *dev, dma_addr_t dma_handle,
 		mvebu_hwcc_sync_io_barrier();
 }
 
+/*
+ * The scatterlist variants translate every entry first and then issue a
+ * single I/O sync barrier for the whole list, instead of one per entry.
+ */
+static int mvebu_hwcc_dma_map_sg(struct device *dev, struct scatterlist *sgl,
+				 int nents, enum dma_data_direction dir,
+				 struct dma_attrs *attrs)
+{
+	struct scatterlist *sg;
+	int i;
+
+	for_each_sg(sgl, sg, nents, i) {
+		sg->dma_address = pfn_to_dma(dev, page_to_pfn(sg_page(sg))) +
+				  sg->offset;
+		sg_dma_len(sg) = sg->length;
+	}
+
+	if (dir != DMA_TO_DEVICE)
+		mvebu_hwcc_sync_io_barrier();
+	return nents;
+}
+
+static void mvebu_hwcc_dma_unmap_sg(struct device *dev,
+				    struct scatterlist *sgl, int nents,
+				    enum dma_data_direction dir,
+				    struct dma_attrs *attrs)
+{
+	if (dir != DMA_TO_DEVICE)
+		mvebu_hwcc_sync_io_barrier();
+}
+
+static void mvebu_hwcc_dma_sync_sg(struct device *dev,
+				   struct scatterlist *sgl, int nents,
+				   enum dma_data_direction dir)
+{
+	if (dir != DMA_TO_DEVICE)
+		mvebu_hwcc_sync_io_barrier();
+}
+
 static struct dma_map_ops mvebu_hwcc_dma_ops = {
 	.alloc			= arm_coherent_dma_alloc,
 	.free			= arm_coherent_dma_free,
@@ -126,12 +165,12 @@ static struct dma_map_ops mvebu_hwcc_dma_ops = {
 	.map_page		= mvebu_hwcc_dma_map_page,
 	.unmap_page		= mvebu_hwcc_dma_unmap_page,
 	.get_sgtable		= arm_dma_get_sgtable,
-	.map_sg			= arm_dma_map_sg,
-	.unmap_sg		= arm_dma_unmap_sg,
+	.map_sg			= mvebu_hwcc_dma_map_sg,
+	.unmap_sg		= mvebu_hwcc_dma_unmap_sg,
 	.sync_single_for_cpu	= mvebu_hwcc_dma_sync,
 	.sync_single_for_device	= mvebu_hwcc_dma_sync,
-	.sync_sg_for_cpu	= arm_dma_sync_sg_for_cpu,
-	.sync_sg_for_device	= arm_dma_sync_sg_for_device,
+	.sync_sg_for_cpu	= mvebu_hwcc_dma_sync_sg,
+	.sync_sg_for_device	= mvebu_hwcc_dma_sync_sg,
 	.set_dma_mask		= arm_dma_set_mask,
 };
 
@@ -116,11 +116,13 @@ static void __init armada_380_smp_prepare_cpus(unsigned int max_cpus)
  * for this CPU might be in the deep idle state, preventing this CPU
  * from receiving interrupts. Here, we therefore take out the current
  * CPU from this state, which was entered by armada_38x_cpu_die()
- * below.
+ * below. The CPU then opens its MPIC doorbells to MSIs; the MPIC
+ * parent interrupt is unmasked by the CPU_STARTING notifier below.
  */
 static void armada_38x_secondary_init(unsigned int cpu)
 {
 	mvebu_v7_pmsu_idle_exit();
+	armada_38x_mpic_msi_cpu_init();
 }
 
 #ifdef CONFIG_HOTPLUG_CPU
@@ -58,6 +58,8 @@ __FBSDID("$FreeBSD: src/sys/opencrypto/cryptodev.c,v 1.34 2007/05/09 19:37:02 gn
 #include <linux/file.h>
 #include <linux/mount.h>
 #include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/highmem.h>
 #include <asm/uaccess.h>
 
 #include <cryptodev.h>
@@ -70,6 +72,23 @@ int cryptodev_debug = 0;
 module_param(cryptodev_debug, int, 0644);
 MODULE_PARM_DESC(cryptodev_debug, "Enable cryptodev debug");
 
+/*
+ * zero-copy mode: pin the user pages of a request and pass them to the
+ * driver as uio fragments instead of bouncing through a kmalloc buffer.
+ * Small requests are cheaper to copy than to pin, hence the threshold.
+ */
+int cryptodev_zerocopy = 0;
+module_param(cryptodev_zerocopy, int, 0644);
+MODULE_PARM_DESC(cryptodev_zerocopy, "Map user pages directly into requests");
+
+int cryptodev_zc_min = 1024;
+module_param(cryptodev_zc_min, int, 0644);
+MODULE_PARM_DESC(cryptodev_zc_min, "Smallest request (bytes) sent zero-copy");
+
+/* user pages a single request may span, one more iovec is kept for the MAC */
+#define CRYPTO_ZC_MAX_PAGES	((CRYPTO_MAX_DATA_LEN) / PAGE_SIZE + 2)
+#define CRYPTO_ZC_MAX_IOV	(CRYPTO_ZC_MAX_PAGES + 1)
+
 struct csession_info {
 	u_int16_t	blocksize;
 	u_int16_t	minkey, maxkey;
@@ -104,6 +123,13 @@ struct csession {
 	struct iovec	iovec;
 	struct uio	uio;
 	int		error;
+
+	/* zero-copy state, valid while zc_npages != 0 */
+	struct iovec	zc_iov[CRYPTO_ZC_MAX_IOV];
+	struct page	*zc_pages[CRYPTO_ZC_MAX_PAGES];
+	int		zc_npages;
+	int		zc_write;
+	u_char		zc_mac[HASH_MAX_LEN];
 };
 
 struct fcrypt {
@@ -188,6 +214,122 @@ checkcrid(int crid)
 	return 0;
 }
 
+/*
+ * Pin the user buffer that the engine should work on in place and describe
+ * it with one iovec per run of virtually contiguous lowmem pages.  When the
+ * caller asked for a separate destination the source is copied into the
+ * pinned destination pages, which still saves the copy back to userspace.
+ * Returns 1 if the request is set up for zero-copy, 0 to use the bounce
+ * buffer instead.
+ */
+static int
+cryptodev_zc_map(struct csession *cse, struct crypt_op *cop)
+{
+	unsigned long uaddr, off;
+	caddr_t ubuf, src;
+	struct iovec *iov;
+	int npages, got, i, len, error;
+
+	if (!cryptodev_zerocopy || cop->len < cryptodev_zc_min)
+		return 0;
+
+	/* the engine works in place, a cipher needs somewhere to write to */
+	if (cse->info.blocksize && cop->dst == NULL)
+		return 0;
+
+	/* hash only requests are read in place, everything else is written */
+	ubuf = cop->dst ? cop->dst : cop->src;
+	cse->zc_write = cop->dst != NULL;
+
+	uaddr = (unsigned long) ubuf;
+	off = uaddr & ~PAGE_MASK;
+	npages = (off + cop->len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+	if (npages > CRYPTO_ZC_MAX_PAGES)
+		return 0;
+
+	got = get_user_pages_fast(uaddr & PAGE_MASK, npages, cse->zc_write,
+			cse->zc_pages);
+	if (got < 0)
+		return 0;
+	cse->zc_npages = got;
+	if (got < npages)
+		goto fallback;
+
+	/* the engine needs a linear mapping to build its descriptors */
+	iov = cse->zc_iov;
+	iov->iov_base = NULL;
+	iov->iov_len = 0;
+	len = cop->len;
+	for (i = 0; i < npages; i++) {
+		struct page *page = cse->zc_pages[i];
+		int chunk = min_t(int, len, PAGE_SIZE - off);
+
+		if (PageHighMem(page))
+			goto fallback;
+		if (iov->iov_base &&
+				(caddr_t) iov->iov_base + iov->iov_len ==
+				(caddr_t) page_address(page) + off) {
+			iov->iov_len += chunk;
+		} else {
+			if (iov->iov_base)
+				iov++;
+			iov->iov_base = (caddr_t) page_address(page) + off;
+			iov->iov_len = chunk;
+		}
+		len -= chunk;
+		off = 0;
+	}
+	iov++;
+
+	if (cse->info.authsize) {
+		iov->iov_base = cse->zc_mac;
+		iov->iov_len = cse->info.authsize;
+		iov++;
+	}
+
+	if (cop->dst && cop->dst != cop->src) {
+		src = cop->src;
+		for (i = 0; i < iov - cse->zc_iov; i++) {
+			if (cse->zc_iov[i].iov_base == cse->zc_mac)
+				break;
+			error = copy_from_user(cse->zc_iov[i].iov_base, src,
+					cse->zc_iov[i].iov_len);
+			if (error) {
+				dprintk("%s: bad zero-copy src copy\n", __FUNCTION__);
+				goto fallback;
+			}
+			src += cse->zc_iov[i].iov_len;
+		}
+	}
+
+	cse->uio.uio_iov = cse->zc_iov;
+	cse->uio.uio_iovcnt = iov - cse->zc_iov;
+	dprintk("%s: %d pages in %d frags\n", __FUNCTION__, npages,
+			cse->uio.uio_iovcnt);
+	return 1;
+
+fallback:
+	for (i = 0; i < cse->zc_npages; i++)
+		put_page(cse->zc_pages[i]);
+	cse->zc_npages = 0;
+	return 0;
+}
+
+static void
+cryptodev_zc_unmap(struct csession *cse)
+{
+	int i;
+
+	for (i = 0; i < cse->zc_npages; i++) {
+		if (cse->zc_write) {
+			flush_dcache_page(cse->zc_pages[i]);
+			set_page_dirty_lock(cse->zc_pages[i]);
+		}
+		put_page(cse->zc_pages[i]);
+	}
+	cse->zc_npages = 0;
+}
+
 static int
 cryptodev_op(struct csession *cse, struct crypt_op *cop)
 {
@@ -219,13 +361,17 @@ cryptodev_op(struct csession *cse, struct crypt_op *cop)
 	cse->uio.uio_iov[0].iov_len = cop->len;
 	if (cse->info.authsize)
 		cse->uio.uio_iov[0].iov_len += cse->info.authsize;
-	cse->uio.uio_iov[0].iov_base = kmalloc(cse->uio.uio_iov[0].iov_len,
-			GFP_KERNEL);
+	cse->uio.uio_iov[0].iov_base = NULL;
 
-	if (cse->uio.uio_iov[0].iov_base == NULL) {
-		dprintk("%s: iov_base kmalloc(%d) failed\n", __FUNCTION__,
-				(int)cse->uio.uio_iov[0].iov_len);
-		return (ENOMEM);
+	if (!cryptodev_zc_map(cse, cop)) {
+		cse->uio.uio_iov[0].iov_base = kmalloc(cse->uio.uio_iov[0].iov_len,
+				GFP_KERNEL);
+
+		if (cse->uio.uio_iov[0].iov_base == NULL) {
+			dprintk("%s: iov_base kmalloc(%d) failed\n", __FUNCTION__,
+					(int)cse->uio.uio_iov[0].iov_len);
+			return (ENOMEM);
+		}
 	}
 
 	crp = crypto_getreq((cse->info.blocksize != 0) + (cse->info.authsize != 0));
@@ -253,8 +399,8 @@ cryptodev_op(struct csession *cse, struct crypt_op *cop)
 		goto bail;
 	}
 
-	if ((error = copy_from_user(cse->uio.uio_iov[0].iov_base, cop->src,
-					cop->len))) {
+	if (!cse->zc_npages && (error = copy_from_user(cse->uio.uio_iov[0].iov_base,
+					cop->src, cop->len))) {
 		dprintk("%s: bad copy\n", __FUNCTION__);
 		goto bail;
 	}
@@ -282,7 +428,7 @@ cryptodev_op(struct csession *cse, struct crypt_op *cop)
 		crde->crd_klen = cse->keylen * 8;
 	}
 
-	crp->crp_ilen = cse->uio.uio_iov[0].iov_len;
+	crp->crp_ilen = cop->len + cse->info.authsize;
 	crp->crp_flags = CRYPTO_F_IOV | CRYPTO_F_CBIMM
 		       | (cop->flags & COP_F_BATCH);
 	crp->crp_buf = (caddr_t)&cse->uio;
@@ -369,6 +515,15 @@ cryptodev_op(struct csession *cse, struct crypt_op *cop)
 		goto bail;
 	}
 
+	if (cse->zc_npages) {
+		/* data is already in place, only the MAC lives in the kernel */
+		if (cop->mac && (error = copy_to_user(cop->mac, cse->zc_mac,
+						cse->info.authsize))) {
+			dprintk("%s bad mac copy\n", __FUNCTION__);
+		}
+		goto bail;
+	}
+
 	if (cop->dst && (error = copy_to_user(cop->dst,
 					cse->uio.uio_iov[0].iov_base, cop->len))) {
 		dprintk("%s bad dst copy\n", __FUNCTION__);
@@ -386,7 +541,10 @@ cryptodev_op(struct csession *cse, struct crypt_op *cop)
 bail:
 	if (crp)
 		crypto_freereq(crp);
-	if (cse->uio.uio_iov[0].iov_base)
+	if (cse->zc_npages) {
+		cryptodev_zc_unmap(cse);
+		cse->uio.uio_iov = &cse->iovec;
+	} else if (cse->uio.uio_iov[0].iov_base)
 		kfree(cse->uio.uio_iov[0].iov_base);
 
 	return (error);
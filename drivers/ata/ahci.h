@@ -84,6 +84,8 @@ enum {
 	HOST_IRQ_STAT		= 0x08, /* interrupt status */
 	HOST_PORTS_IMPL		= 0x0c, /* bitmap of implemented ports */
 	HOST_VERSION		= 0x10, /* AHCI spec. version compliancy */
+	HOST_CCC_CTL		= 0x14, /* Command Completion Coalescing control */
+	HOST_CCC_PORTS		= 0x18, /* ports covered by CCC */
 	HOST_EM_LOC		= 0x1c, /* Enclosure Management location */
 	HOST_EM_CTL		= 0x20, /* Enclosure Management Control */
 	HOST_CAP2		= 0x24, /* host capabilities, extended */
@@ -93,6 +95,15 @@ enum {
 	HOST_IRQ_EN		= (1 << 1),  /* global IRQ enable */
 	HOST_AHCI_EN		= (1 << 31), /* AHCI enabled */
 
+	/* HOST_CCC_CTL bits */
+	HOST_CCC_EN		= (1 << 0),  /* CCC enable */
+	HOST_CCC_INT_SHIFT	= 3,	     /* HOST_IRQ_STAT bit used by CCC */
+	HOST_CCC_INT_MASK	= (0x1f << 3),
+	HOST_CCC_CC_SHIFT	= 8,	     /* command completions threshold */
+	HOST_CCC_CC_MAX		= 0xff,
+	HOST_CCC_TV_SHIFT	= 16,	     /* timeout value, ms */
+	HOST_CCC_TV_MAX		= 0xffff,
+
 	/* HOST_CAP bits */
 	HOST_CAP_SXS		= (1 << 5),  /* Supports External SATA */
 	HOST_CAP_EMS		= (1 << 6),  /* Enclosure Management support */
@@ -321,6 +332,10 @@ struct ahci_host_priv {
 	u32			em_buf_sz;	/* EM buffer size in byte */
 	u32			em_msg_type;	/* EM message type */
 	struct clk		*clk;		/* Only for platforms supporting clk */
+	u32			ccc_ports;	/* ports coalesced by CCC, 0 if off */
+	unsigned int		ccc_irq;	/* HOST_IRQ_STAT bit raised by CCC */
+	unsigned int		ccc_timeout;	/* CCC timeout in ms, 0 disables */
+	unsigned int		ccc_count;	/* CCC completions, 0 disables */
 };
 
 extern int ahci_ignore_sss;
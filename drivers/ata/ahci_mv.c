@@ -41,6 +41,14 @@
 #define VENDOR_SPECIFIC_0_ADDR  0xa0
 #define VENDOR_SPECIFIC_0_DATA  0xa4
 
+static unsigned int ccc_timeout = 1;
+module_param(ccc_timeout, uint, 0444);
+MODULE_PARM_DESC(ccc_timeout, "Command completion coalescing timeout in ms, 0 disables (default 1)");
+
+static unsigned int ccc_count = 8;
+module_param(ccc_count, uint, 0444);
+MODULE_PARM_DESC(ccc_count, "Command completions per coalesced interrupt, 0 disables (default 8)");
+
 static void ahci_mv_windows_config(struct ahci_host_priv *hpriv,
 				   const struct mbus_dram_target_info *dram)
 {
@@ -210,6 +218,16 @@ static int ahci_mv_probe(struct platform_device *pdev)
 		return rc;
 	}
 
+	/*
+	 * With deep NCQ queues on several disks, take one interrupt per
+	 * batch of completions; the thresholds can be tuned at runtime
+	 * through the ahci_ccc_* host attributes.
+	 */
+	if (hpriv->cap & HOST_CAP_CCC) {
+		hpriv->ccc_timeout = min(ccc_timeout, (unsigned int)HOST_CCC_TV_MAX);
+		hpriv->ccc_count = min(ccc_count, (unsigned int)HOST_CCC_CC_MAX);
+	}
+
 	ahci_init_controller(host);
 	ahci_print_info(host, "platform");
 
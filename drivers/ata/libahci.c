@@ -115,6 +115,16 @@ static ssize_t ahci_store_em_buffer(struct device *dev,
 				    const char *buf, size_t size);
 static ssize_t ahci_show_em_supported(struct device *dev,
 				      struct device_attribute *attr, char *buf);
+static ssize_t ahci_show_ccc_timeout(struct device *dev,
+				     struct device_attribute *attr, char *buf);
+static ssize_t ahci_store_ccc_timeout(struct device *dev,
+				      struct device_attribute *attr,
+				      const char *buf, size_t size);
+static ssize_t ahci_show_ccc_count(struct device *dev,
+				   struct device_attribute *attr, char *buf);
+static ssize_t ahci_store_ccc_count(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t size);
 
 static DEVICE_ATTR(ahci_host_caps, S_IRUGO, ahci_show_host_caps, NULL);
 static DEVICE_ATTR(ahci_host_cap2, S_IRUGO, ahci_show_host_cap2, NULL);
@@ -123,6 +133,10 @@ static DEVICE_ATTR(ahci_port_cmd, S_IRUGO, ahci_show_port_cmd, NULL);
 static DEVICE_ATTR(em_buffer, S_IWUSR | S_IRUGO,
 		   ahci_read_em_buffer, ahci_store_em_buffer);
 static DEVICE_ATTR(em_message_supported, S_IRUGO, ahci_show_em_supported, NULL);
+static DEVICE_ATTR(ahci_ccc_timeout, S_IWUSR | S_IRUGO,
+		   ahci_show_ccc_timeout, ahci_store_ccc_timeout);
+static DEVICE_ATTR(ahci_ccc_count, S_IWUSR | S_IRUGO,
+		   ahci_show_ccc_count, ahci_store_ccc_count);
 
 struct device_attribute *ahci_shost_attrs[] = {
 	&dev_attr_link_power_management_policy,
@@ -134,6 +148,8 @@ struct device_attribute *ahci_shost_attrs[] = {
 	&dev_attr_ahci_port_cmd,
 	&dev_attr_em_buffer,
 	&dev_attr_em_message_supported,
+	&dev_attr_ahci_ccc_timeout,
+	&dev_attr_ahci_ccc_count,
 	NULL
 };
 EXPORT_SYMBOL_GPL(ahci_shost_attrs);
@@ -265,6 +281,103 @@ static ssize_t ahci_show_port_cmd(struct device *dev,
 	return sprintf(buf, "%x\n", readl(port_mmio + PORT_CMD));
 }
 
+/*
+ * Program Command Completion Coalescing from hpriv->ccc_timeout and
+ * hpriv->ccc_count.  Completions on all implemented ports are then
+ * reported through a single HOST_IRQ_STAT bit once either threshold is
+ * hit, instead of one interrupt per command.  Must be called with
+ * interrupts from the host disabled or under host->lock.
+ */
+static void ahci_ccc_apply(struct ata_host *host)
+{
+	struct ahci_host_priv *hpriv = host->private_data;
+	void __iomem *mmio = hpriv->mmio;
+	u32 ctl;
+
+	if (!(hpriv->cap & HOST_CAP_CCC))
+		return;
+
+	/* CCC_PORTS and the thresholds may only change while disabled */
+	ctl = readl(mmio + HOST_CCC_CTL) & ~HOST_CCC_EN;
+	writel(ctl, mmio + HOST_CCC_CTL);
+
+	if (!hpriv->ccc_timeout || !hpriv->ccc_count) {
+		hpriv->ccc_ports = 0;
+		return;
+	}
+
+	hpriv->ccc_irq = (ctl & HOST_CCC_INT_MASK) >> HOST_CCC_INT_SHIFT;
+	hpriv->ccc_ports = hpriv->port_map & ~(1 << hpriv->ccc_irq);
+	writel(hpriv->ccc_ports, mmio + HOST_CCC_PORTS);
+
+	ctl = (ctl & HOST_CCC_INT_MASK) |
+	      (hpriv->ccc_timeout << HOST_CCC_TV_SHIFT) |
+	      (hpriv->ccc_count << HOST_CCC_CC_SHIFT);
+	writel(ctl, mmio + HOST_CCC_CTL);
+	writel(ctl | HOST_CCC_EN, mmio + HOST_CCC_CTL);
+}
+
+static ssize_t ahci_ccc_store(struct device *dev, const char *buf,
+			      size_t size, unsigned int max, bool timeout)
+{
+	struct Scsi_Host *shost = class_to_shost(dev);
+	struct ata_port *ap = ata_shost_to_port(shost);
+	struct ahci_host_priv *hpriv = ap->host->private_data;
+	unsigned long flags;
+	unsigned int val;
+
+	/* per-port MSI vectors have no CCC interrupt handling */
+	if (!(hpriv->cap & HOST_CAP_CCC) || (hpriv->flags & AHCI_HFLAG_MULTI_MSI))
+		return -EOPNOTSUPP;
+
+	if (kstrtouint(buf, 0, &val) || val > max)
+		return -EINVAL;
+
+	spin_lock_irqsave(&ap->host->lock, flags);
+	if (timeout)
+		hpriv->ccc_timeout = val;
+	else
+		hpriv->ccc_count = val;
+	ahci_ccc_apply(ap->host);
+	spin_unlock_irqrestore(&ap->host->lock, flags);
+
+	return size;
+}
+
+static ssize_t ahci_show_ccc_timeout(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct Scsi_Host *shost = class_to_shost(dev);
+	struct ata_port *ap = ata_shost_to_port(shost);
+	struct ahci_host_priv *hpriv = ap->host->private_data;
+
+	return sprintf(buf, "%u\n", hpriv->ccc_timeout);
+}
+
+static ssize_t ahci_store_ccc_timeout(struct device *dev,
+				      struct device_attribute *attr,
+				      const char *buf, size_t size)
+{
+	return ahci_ccc_store(dev, buf, size, HOST_CCC_TV_MAX, true);
+}
+
+static ssize_t ahci_show_ccc_count(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct Scsi_Host *shost = class_to_shost(dev);
+	struct ata_port *ap = ata_shost_to_port(shost);
+	struct ahci_host_priv *hpriv = ap->host->private_data;
+
+	return sprintf(buf, "%u\n", hpriv->ccc_count);
+}
+
+static ssize_t ahci_store_ccc_count(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t size)
+{
+	return ahci_ccc_store(dev, buf, size, HOST_CCC_CC_MAX, false);
+}
+
 static ssize_t ahci_read_em_buffer(struct device *dev,
 				   struct device_attribute *attr, char *buf)
 {
@@ -1136,6 +1249,8 @@ void ahci_init_controller(struct ata_host *host)
 		ahci_port_init(host->dev, ap, i, mmio, port_mmio);
 	}
 
+	ahci_ccc_apply(host);
+
 	tmp = readl(mmio + HOST_CTL);
 	VPRINTK("HOST_CTL 0x%x\n", tmp);
 	writel(tmp | HOST_IRQ_EN, mmio + HOST_CTL);
@@ -1878,6 +1993,14 @@ irqreturn_t ahci_interrupt(int irq, void *dev_instance)
 
 	spin_lock(&host->lock);
 
+	/*
+	 * A coalesced completion interrupt doesn't say which ports have
+	 * finished commands; scan all of them, each port reaping every
+	 * completed tag in one go.
+	 */
+	if (hpriv->ccc_ports && (irq_stat & (1 << hpriv->ccc_irq)))
+		irq_masked |= hpriv->ccc_ports;
+
 	for (i = 0; i < host->n_ports; i++) {
 		struct ata_port *ap;
 
@@ -42,6 +42,10 @@ static DEFINE_RWLOCK(cpufreq_driver_lock);
 DEFINE_MUTEX(cpufreq_governor_lock);
 static LIST_HEAD(cpufreq_policy_list);
 
+/* Peak network load reported since the governor's last sample */
+DEFINE_PER_CPU(unsigned int, cpufreq_net_load);
+EXPORT_PER_CPU_SYMBOL_GPL(cpufreq_net_load);
+
 #ifdef CONFIG_HOTPLUG_CPU
 /* This one keeps track of the previously set governor of a removed CPU */
 static DEFINE_PER_CPU(char[CPUFREQ_NAME_LEN], cpufreq_cpu_governor);
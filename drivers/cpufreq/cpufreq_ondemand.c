@@ -147,6 +147,21 @@ static void dbs_freq_increase(struct cpufreq_policy *policy, unsigned int freq)
 			CPUFREQ_RELATION_L : CPUFREQ_RELATION_H);
 }
 
+/*
+ * Collect the peak network load reported by the CPUs of this policy since the
+ * last sample.  Idle time alone lags packet bursts: a CPU that has just gone
+ * through its NAPI budget may still have been idle for most of the window.
+ */
+static unsigned int od_net_load(struct cpufreq_policy *policy)
+{
+	unsigned int j, load = 0;
+
+	for_each_cpu(j, policy->cpus)
+		load = max(load, xchg(&per_cpu(cpufreq_net_load, j), 0));
+
+	return min(load, 100U);
+}
+
 /*
  * Every sampling_rate, we check, if current idle time is less than 20%
  * (default), then we try to increase frequency. Else, we adjust the frequency
@@ -158,13 +173,29 @@ static void od_check_cpu(int cpu, unsigned int load)
 	struct cpufreq_policy *policy = dbs_info->cdbs.cur_policy;
 	struct dbs_data *dbs_data = policy->governor_data;
 	struct od_dbs_tuners *od_tuners = dbs_data->tuners;
+	bool net_boost = false;
 
 	dbs_info->freq_lo = 0;
 
+	if (od_tuners->net_boost) {
+		unsigned int net_load = od_net_load(policy);
+
+		if (net_load > load) {
+			load = net_load;
+			net_boost = true;
+		}
+	}
+
 	/* Check for frequency increase */
 	if (load > od_tuners->up_threshold) {
-		/* If switching to max speed, apply sampling_down_factor */
-		if (policy->cur < policy->max)
+		/*
+		 * If switching to max speed, apply sampling_down_factor, unless
+		 * only network load got us here: bursts are short and we want
+		 * to drop back at the next quiet sample.
+		 */
+		if (net_boost)
+			dbs_info->rate_mult = 1;
+		else if (policy->cur < policy->max)
 			dbs_info->rate_mult =
 				od_tuners->sampling_down_factor;
 		dbs_freq_increase(policy, policy->max);
@@ -422,12 +453,34 @@ static ssize_t store_powersave_bias(struct dbs_data *dbs_data, const char *buf,
 	return count;
 }
 
+static ssize_t store_net_boost(struct dbs_data *dbs_data, const char *buf,
+		size_t count)
+{
+	struct od_dbs_tuners *od_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+	unsigned int j;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	od_tuners->net_boost = !!input;
+
+	/* drop whatever was reported while the input was ignored */
+	for_each_online_cpu(j)
+		per_cpu(cpufreq_net_load, j) = 0;
+
+	return count;
+}
+
 show_store_one(od, sampling_rate);
 show_store_one(od, io_is_busy);
 show_store_one(od, up_threshold);
 show_store_one(od, sampling_down_factor);
 show_store_one(od, ignore_nice_load);
 show_store_one(od, powersave_bias);
+show_store_one(od, net_boost);
 declare_show_sampling_rate_min(od);
 
 gov_sys_pol_attr_rw(sampling_rate);
@@ -436,6 +489,7 @@ gov_sys_pol_attr_rw(up_threshold);
 gov_sys_pol_attr_rw(sampling_down_factor);
 gov_sys_pol_attr_rw(ignore_nice_load);
 gov_sys_pol_attr_rw(powersave_bias);
+gov_sys_pol_attr_rw(net_boost);
 gov_sys_pol_attr_ro(sampling_rate_min);
 
 static struct attribute *dbs_attributes_gov_sys[] = {
@@ -446,6 +500,7 @@ static struct attribute *dbs_attributes_gov_sys[] = {
 	&ignore_nice_load_gov_sys.attr,
 	&powersave_bias_gov_sys.attr,
 	&io_is_busy_gov_sys.attr,
+	&net_boost_gov_sys.attr,
 	NULL
 };
 
@@ -462,6 +517,7 @@ static struct attribute *dbs_attributes_gov_pol[] = {
 	&ignore_nice_load_gov_pol.attr,
 	&powersave_bias_gov_pol.attr,
 	&io_is_busy_gov_pol.attr,
+	&net_boost_gov_pol.attr,
 	NULL
 };
 
@@ -508,6 +564,7 @@ static int od_init(struct dbs_data *dbs_data)
 	tuners->ignore_nice_load = 0;
 	tuners->powersave_bias = default_powersave_bias;
 	tuners->io_is_busy = should_io_be_busy();
+	tuners->net_boost = 1;
 
 	dbs_data->tuners = tuners;
 	mutex_init(&dbs_data->mutex);
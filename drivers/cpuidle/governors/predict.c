@@ -0,0 +1,333 @@
+/*
+ * predict.c - an idle governor that learns interrupt wakeup patterns
+ *
+ * Deep idle states on Armada 370/XP/38x leave the coherency fabric and
+ * may power down the L2, so waking up from them costs tens of
+ * microseconds.  On a network appliance most wakeups are NAPI
+ * interrupts, which arrive well before the next timer event that the
+ * menu governor bases its estimate on.  This governor keeps a per-CPU
+ * running average (and mean deviation) of the observed idle intervals
+ * and lets drivers that know when their next interrupt is due pass a
+ * wakeup hint, so that the deep state is only used when the CPU is
+ * really going to stay idle long enough.
+ *
+ * This code is licenced under the GPL.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cpuidle.h>
+#include <linux/pm_qos.h>
+#include <linux/time.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/tick.h>
+#include <linux/module.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
+/* EWMA weights, as shifts: avg gets 1/8 of a new sample, dev 1/4 */
+#define AVG_SHIFT	3
+#define DEV_SHIFT	2
+
+/* samples above this are timer driven and only decay the average */
+#define MAX_INTERESTING	50000
+
+static unsigned int latency_margin = 2;
+module_param(latency_margin, uint, 0644);
+MODULE_PARM_DESC(latency_margin,
+		 "Required ratio of predicted idle time to state exit latency");
+
+struct predict_state_stats {
+	unsigned long	usage;
+	u64		time_us;
+	unsigned long	too_deep;	/* woke before target residency */
+	unsigned long	too_shallow;	/* a deeper state would have paid off */
+};
+
+struct predict_device {
+	int		last_state_idx;
+	int		needs_update;
+
+	unsigned int	expected_us;
+	unsigned int	predicted_us;
+	unsigned int	exit_us;
+
+	/* learnt idle interval, in microseconds */
+	unsigned int	avg_us;
+	unsigned int	dev_us;
+
+	/* interrupt announced through cpuidle_wakeup_hint() */
+	ktime_t		hint;
+
+	unsigned long	hint_used;
+	struct predict_state_stats stats[CPUIDLE_STATE_MAX];
+};
+
+static DEFINE_PER_CPU(struct predict_device, predict_devices);
+
+/**
+ * cpuidle_wakeup_hint - announce an interrupt expected on this CPU
+ * @usecs: time from now by which the interrupt is expected
+ *
+ * Called by drivers that program an interrupt moderation timer (e.g.
+ * NAPI RX coalescing) right before they re-enable their interrupt, so
+ * that the governor doesn't select a state whose target residency is
+ * longer than the expected idle period.  The latest hint wins and is
+ * consumed by the next idle period only.
+ */
+void cpuidle_wakeup_hint(unsigned int usecs)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+
+	data->hint = ktime_add_us(ktime_get(), usecs);
+}
+EXPORT_SYMBOL_GPL(cpuidle_wakeup_hint);
+
+static void predict_update(struct cpuidle_driver *drv,
+			   struct cpuidle_device *dev);
+
+/**
+ * predict_select - selects the next idle state to enter
+ * @drv: cpuidle driver containing state data
+ * @dev: the CPU
+ */
+static int predict_select(struct cpuidle_driver *drv,
+			  struct cpuidle_device *dev)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+	int latency_req = pm_qos_request(PM_QOS_CPU_DMA_LATENCY);
+	unsigned int predicted_us;
+	struct timespec t;
+	int i;
+
+	if (data->needs_update) {
+		predict_update(drv, dev);
+		data->needs_update = 0;
+	}
+
+	data->last_state_idx = 0;
+	data->exit_us = 0;
+
+	/* Special case when user has set very strict latency requirement */
+	if (unlikely(latency_req == 0)) {
+		data->hint.tv64 = 0;
+		return 0;
+	}
+
+	t = ktime_to_timespec(tick_nohz_get_sleep_length());
+	data->expected_us = t.tv_sec * USEC_PER_SEC + t.tv_nsec / NSEC_PER_USEC;
+	predicted_us = data->expected_us;
+
+	/*
+	 * A steady interrupt pattern (deviation small against the average)
+	 * is trusted as is; an erratic one only caps the estimate at the
+	 * average plus its deviation.
+	 */
+	if (data->avg_us) {
+		unsigned int learnt = data->avg_us;
+
+		if (data->dev_us > data->avg_us / 2)
+			learnt += data->dev_us;
+		predicted_us = min(predicted_us, learnt);
+	}
+
+	if (data->hint.tv64) {
+		s64 hint_us = ktime_us_delta(data->hint, ktime_get());
+
+		data->hint.tv64 = 0;
+		if (hint_us < 0)
+			hint_us = 0;
+		if (hint_us < predicted_us) {
+			predicted_us = hint_us;
+			data->hint_used++;
+		}
+	}
+	data->predicted_us = predicted_us;
+
+	if (data->expected_us > 5 &&
+	    !drv->states[CPUIDLE_DRIVER_STATE_START].disabled &&
+	    dev->states_usage[CPUIDLE_DRIVER_STATE_START].disable == 0)
+		data->last_state_idx = CPUIDLE_DRIVER_STATE_START;
+
+	for (i = CPUIDLE_DRIVER_STATE_START; i < drv->state_count; i++) {
+		struct cpuidle_state *s = &drv->states[i];
+		struct cpuidle_state_usage *su = &dev->states_usage[i];
+
+		if (s->disabled || su->disable)
+			continue;
+		if (s->target_residency > predicted_us)
+			continue;
+		if (s->exit_latency > latency_req)
+			continue;
+		if (s->exit_latency * latency_margin > predicted_us)
+			continue;
+
+		data->last_state_idx = i;
+		data->exit_us = s->exit_latency;
+	}
+
+	return data->last_state_idx;
+}
+
+/**
+ * predict_reflect - records that data structures need update
+ * @dev: the CPU
+ * @index: the index of actual entered state
+ */
+static void predict_reflect(struct cpuidle_device *dev, int index)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+
+	data->last_state_idx = index;
+	if (index >= 0)
+		data->needs_update = 1;
+}
+
+/**
+ * predict_update - learns from the idle period that just ended
+ * @drv: cpuidle driver containing state data
+ * @dev: the CPU
+ */
+static void predict_update(struct cpuidle_driver *drv,
+			   struct cpuidle_device *dev)
+{
+	struct predict_device *data = &__get_cpu_var(predict_devices);
+	int last_idx = data->last_state_idx;
+	struct cpuidle_state *target = &drv->states[last_idx];
+	struct predict_state_stats *st = &data->stats[last_idx];
+	unsigned int measured_us;
+	int diff, next;
+
+	if (unlikely(!(target->flags & CPUIDLE_FLAG_TIME_VALID)))
+		measured_us = data->expected_us;
+	else
+		measured_us = cpuidle_get_last_residency(dev);
+
+	if (measured_us > data->exit_us)
+		measured_us -= data->exit_us;
+
+	st->usage++;
+	st->time_us += measured_us;
+
+	if (last_idx > CPUIDLE_DRIVER_STATE_START &&
+	    measured_us < target->target_residency)
+		st->too_deep++;
+
+	/* look for the next deeper state we were allowed to use */
+	for (next = last_idx + 1; next < drv->state_count; next++) {
+		if (!drv->states[next].disabled &&
+		    !dev->states_usage[next].disable &&
+		    drv->states[next].exit_latency <=
+		    pm_qos_request(PM_QOS_CPU_DMA_LATENCY))
+			break;
+	}
+	if (next < drv->state_count &&
+	    measured_us >= drv->states[next].target_residency +
+			   drv->states[next].exit_latency)
+		st->too_shallow++;
+
+	if (measured_us > MAX_INTERESTING)
+		measured_us = MAX_INTERESTING;
+
+	if (!data->avg_us) {
+		data->avg_us = measured_us;
+		data->dev_us = measured_us / 2;
+		return;
+	}
+
+	diff = (int)measured_us - (int)data->avg_us;
+	data->avg_us += diff >> AVG_SHIFT;
+	if (!data->avg_us)
+		data->avg_us = 1;
+	data->dev_us += ((int)abs(diff) - (int)data->dev_us) >> DEV_SHIFT;
+}
+
+/**
+ * predict_enable_device - reset the per-CPU model
+ * @drv: cpuidle driver
+ * @dev: the CPU
+ */
+static int predict_enable_device(struct cpuidle_driver *drv,
+				 struct cpuidle_device *dev)
+{
+	struct predict_device *data = &per_cpu(predict_devices, dev->cpu);
+
+	memset(data, 0, sizeof(struct predict_device));
+
+	return 0;
+}
+
+static struct cpuidle_governor predict_governor = {
+	.name =		"predict",
+	.rating =	30,
+	.enable =	predict_enable_device,
+	.select =	predict_select,
+	.reflect =	predict_reflect,
+	.owner =	THIS_MODULE,
+};
+
+#ifdef CONFIG_DEBUG_FS
+static int predict_stats_show(struct seq_file *m, void *unused)
+{
+	struct cpuidle_driver *drv = cpuidle_get_driver();
+	int cpu, i;
+
+	if (!drv)
+		return 0;
+
+	for_each_online_cpu(cpu) {
+		struct predict_device *data = &per_cpu(predict_devices, cpu);
+
+		seq_printf(m, "cpu%d: avg %u us dev %u us hints %lu\n",
+			   cpu, data->avg_us, data->dev_us, data->hint_used);
+		seq_printf(m, "  %-8s %10s %14s %10s %12s\n", "state",
+			   "usage", "time_us", "too_deep", "too_shallow");
+		for (i = 0; i < drv->state_count; i++) {
+			struct predict_state_stats *st = &data->stats[i];
+
+			seq_printf(m, "  %-8s %10lu %14llu %10lu %12lu\n",
+				   drv->states[i].name, st->usage,
+				   (unsigned long long)st->time_us,
+				   st->too_deep, st->too_shallow);
+		}
+	}
+
+	return 0;
+}
+
+static int predict_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, predict_stats_show, NULL);
+}
+
+static const struct file_operations predict_stats_fops = {
+	.open		= predict_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
+/**
+ * init_predict - initializes the governor
+ */
+static int __init init_predict(void)
+{
+#ifdef CONFIG_DEBUG_FS
+	debugfs_create_file("cpuidle_predict", S_IRUGO, NULL, NULL,
+			    &predict_stats_fops);
+#endif
+	return cpuidle_register_governor(&predict_governor);
+}
+
+/**
+ * exit_predict - exits the governor
+ */
+static void __exit exit_predict(void)
+{
+	cpuidle_unregister_governor(&predict_governor);
+}
+
+MODULE_LICENSE("GPL");
+module_init(init_predict);
+module_exit(exit_predict);
@@ -0,0 +1,673 @@
+/*
+ * Cryptographic API.
+ *
+ * CRC32c offload on the Marvell XOR engine.
+ *
+ * The XOR engine can compute CRC32c over a buffer described by a single
+ * descriptor, but only starting from the standard ~0 seed.  Arbitrary
+ * running checksums are supported by computing each buffer from ~0 on the
+ * engine and folding the previous checksum in with the CRC shift operator,
+ * which for a 2^k byte run is precomputed as a 32x32 GF(2) matrix.
+ *
+ * Two algorithms are registered:
+ *  - a synchronous "crc32c" shash, which offloads large linear buffers and
+ *    sleeps until the engine is done when the caller allows it;
+ *  - an asynchronous "crc32c" ahash, which maps every scatterlist entry,
+ *    queues them on the channel and completes the request from a tasklet
+ *    of its own, scheduled by the XOR cleanup path.
+ * Both fall back to the CPU below offload_threshold or when no channel
+ * with the DMA_CRC32C capability is available.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+#include <crypto/internal/hash.h>
+#include <linux/completion.h>
+#include <linux/crc32.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <linux/highmem.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/module.h>
+#include <linux/scatterlist.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#define CHKSUM_BLOCK_SIZE	1
+#define CHKSUM_DIGEST_SIZE	4
+
+#define CRC32C_POLY_LE		0x82f63b78
+
+/* the engine rejects shorter buffers, longer ones are split */
+#define MV_CRC_MIN_HW_LEN	128
+#define MV_CRC_MAX_HW_LEN	SZ_8M
+#define MV_CRC_SHIFT_ORDERS	24	/* 2^23 bytes == MV_CRC_MAX_HW_LEN */
+#define MV_CRC_INLINE_SEGS	4
+
+static unsigned int offload_threshold = 2048;
+module_param(offload_threshold, uint, 0644);
+MODULE_PARM_DESC(offload_threshold,
+		 "Requests shorter than this are checksummed on the CPU");
+
+/* mv_crc_shift_mat[k] advances a raw crc over 2^k zero bytes */
+static u32 mv_crc_shift_mat[MV_CRC_SHIFT_ORDERS][32];
+
+struct mv_crc_ctx {
+	u32 key;
+};
+
+struct mv_crc_desc_ctx {
+	u32 crc;
+};
+
+/**
+ * struct mv_crc_seg - one engine (or CPU) checksummed chunk
+ * @crc: crc32c of the chunk started from ~0, written by the engine
+ * @len: chunk length in bytes
+ */
+struct mv_crc_seg {
+	u32		crc;
+	unsigned int	len;
+};
+
+/**
+ * struct mv_crc_job - a set of chunks checksummed in flight
+ * @segs: per chunk results, in data order
+ * @nsegs: number of chunks queued so far
+ * @pending: outstanding engine descriptors, plus one for the submitter
+ * @complete: called once the last descriptor has completed
+ */
+struct mv_crc_job {
+	struct mv_crc_seg	*segs;
+	struct mv_crc_seg	inline_segs[MV_CRC_INLINE_SEGS];
+	unsigned int		nsegs;
+	atomic_t		pending;
+	void			(*complete)(struct mv_crc_job *job);
+};
+
+struct mv_crc_req_ctx {
+	u32			crc;
+	u8			*out;
+	struct ahash_request	*req;
+	struct mv_crc_job	job;
+	struct list_head	done_list;
+};
+
+struct mv_crc_sync {
+	struct mv_crc_job	job;
+	struct completion	done;
+};
+
+static u32 gf2_matrix_times(const u32 *mat, u32 vec)
+{
+	u32 sum = 0;
+
+	while (vec) {
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+static void gf2_matrix_square(u32 *square, const u32 *mat)
+{
+	int n;
+
+	for (n = 0; n < 32; n++)
+		square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+static void __init mv_crc_shift_init(void)
+{
+	u32 one_bit[32], two_bits[32], four_bits[32];
+	u32 row = 1;
+	int n;
+
+	/* operator for a single zero bit */
+	one_bit[0] = CRC32C_POLY_LE;
+	for (n = 1; n < 32; n++) {
+		one_bit[n] = row;
+		row <<= 1;
+	}
+
+	gf2_matrix_square(two_bits, one_bit);
+	gf2_matrix_square(four_bits, two_bits);
+	gf2_matrix_square(mv_crc_shift_mat[0], four_bits);
+
+	for (n = 1; n < MV_CRC_SHIFT_ORDERS; n++)
+		gf2_matrix_square(mv_crc_shift_mat[n], mv_crc_shift_mat[n - 1]);
+}
+
+/*
+ * crc register after feeding len zero bytes, i.e. __crc32c_le(crc, 0s, len).
+ * Chunks are never longer than MV_CRC_MAX_HW_LEN, so the table covers len.
+ */
+static u32 mv_crc_shift(u32 crc, unsigned int len)
+{
+	int k;
+
+	for (k = 0; len && crc && k < MV_CRC_SHIFT_ORDERS; k++, len >>= 1)
+		if (len & 1)
+			crc = gf2_matrix_times(mv_crc_shift_mat[k], crc);
+
+	return crc;
+}
+
+static int mv_crc_job_init(struct mv_crc_job *job, unsigned int nsegs,
+			   gfp_t gfp)
+{
+	job->segs = job->inline_segs;
+	if (nsegs > MV_CRC_INLINE_SEGS) {
+		job->segs = kmalloc(nsegs * sizeof(*job->segs), gfp);
+		if (!job->segs)
+			return -ENOMEM;
+	}
+	job->nsegs = 0;
+	atomic_set(&job->pending, 1);
+	return 0;
+}
+
+/* fold the chunk results into the running crc and release the job */
+static u32 mv_crc_job_end(struct mv_crc_job *job, u32 crc)
+{
+	unsigned int i;
+
+	for (i = 0; i < job->nsegs; i++)
+		crc = job->segs[i].crc ^
+			mv_crc_shift(crc ^ ~0, job->segs[i].len);
+
+	if (job->segs != job->inline_segs)
+		kfree(job->segs);
+	return crc;
+}
+
+static void mv_crc_seg_done(void *param)
+{
+	struct mv_crc_job *job = param;
+
+	if (atomic_dec_and_test(&job->pending))
+		job->complete(job);
+}
+
+static void mv_crc_cpu_page(struct mv_crc_seg *seg, struct page *page,
+			    unsigned int offset, unsigned int len)
+{
+	u32 crc = ~0;
+
+	if (!PageHighMem(page)) {
+		crc = __crc32c_le(crc, page_address(page) + offset, len);
+	} else {
+		page += offset >> PAGE_SHIFT;
+		offset &= ~PAGE_MASK;
+		while (len) {
+			unsigned int n = min_t(unsigned int, len,
+					       PAGE_SIZE - offset);
+			u8 *p = kmap_atomic(page);
+
+			crc = __crc32c_le(crc, p + offset, n);
+			kunmap_atomic(p);
+			len -= n;
+			offset = 0;
+			page++;
+		}
+	}
+	seg->crc = crc;
+}
+
+/* queue one physically contiguous chunk, on the engine when possible */
+static void mv_crc_job_add(struct mv_crc_job *job, struct dma_chan *chan,
+			   struct page *page, unsigned int offset,
+			   unsigned int len)
+{
+	struct mv_crc_seg *seg = &job->segs[job->nsegs++];
+	struct dma_device *dev = chan->device;
+	struct dma_async_tx_descriptor *tx;
+	dma_addr_t addr;
+
+	seg->len = len;
+	seg->crc = ~0;
+
+	if (len < MV_CRC_MIN_HW_LEN)
+		goto cpu;
+
+	addr = dma_map_page(dev->dev, page, offset, len, DMA_TO_DEVICE);
+	if (dma_mapping_error(dev->dev, addr))
+		goto cpu;
+
+	/* the channel unmaps the source once the descriptor completes */
+	tx = dev->device_prep_dma_crc32c(chan, addr, len, &seg->crc,
+					 DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!tx) {
+		dma_unmap_page(dev->dev, addr, len, DMA_TO_DEVICE);
+		goto cpu;
+	}
+
+	tx->callback = mv_crc_seg_done;
+	tx->callback_param = job;
+	atomic_inc(&job->pending);
+	dmaengine_submit(tx);
+	return;
+
+cpu:
+	mv_crc_cpu_page(seg, page, offset, len);
+}
+
+/*
+ * Kick the channel and drop the submitter's reference.  Returns true if
+ * every chunk already completed (or ran on the CPU), in which case
+ * job->complete will not be called.
+ */
+static bool mv_crc_job_submit(struct mv_crc_job *job, struct dma_chan *chan)
+{
+	dma_async_issue_pending(chan);
+	return atomic_dec_and_test(&job->pending);
+}
+
+/*
+ * shash interface
+ */
+static int mv_crc_init(struct shash_desc *desc)
+{
+	struct mv_crc_ctx *mctx = crypto_shash_ctx(desc->tfm);
+	struct mv_crc_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	ctx->crc = mctx->key;
+
+	return 0;
+}
+
+static int mv_crc_setkey(struct crypto_shash *tfm, const u8 *key,
+			 unsigned int keylen)
+{
+	struct mv_crc_ctx *mctx = crypto_shash_ctx(tfm);
+
+	if (keylen != sizeof(mctx->key)) {
+		crypto_shash_set_flags(tfm, CRYPTO_TFM_RES_BAD_KEY_LEN);
+		return -EINVAL;
+	}
+	mctx->key = le32_to_cpu(*(__le32 *)key);
+	return 0;
+}
+
+static void mv_crc_sync_done(struct mv_crc_job *job)
+{
+	struct mv_crc_sync *sync = container_of(job, struct mv_crc_sync, job);
+
+	complete(&sync->done);
+}
+
+static u32 mv_crc_offload_linear(struct dma_chan *chan, u32 crc,
+				 const u8 *data, unsigned int len)
+{
+	struct mv_crc_sync sync;
+	unsigned int n;
+
+	if (mv_crc_job_init(&sync.job, DIV_ROUND_UP(len, MV_CRC_MAX_HW_LEN),
+			    GFP_KERNEL))
+		return __crc32c_le(crc, data, len);
+
+	init_completion(&sync.done);
+	sync.job.complete = mv_crc_sync_done;
+
+	while (len) {
+		n = min_t(unsigned int, len, MV_CRC_MAX_HW_LEN);
+		mv_crc_job_add(&sync.job, chan, virt_to_page(data),
+			       offset_in_page(data), n);
+		data += n;
+		len -= n;
+	}
+
+	if (!mv_crc_job_submit(&sync.job, chan))
+		wait_for_completion(&sync.done);
+
+	return mv_crc_job_end(&sync.job, crc);
+}
+
+static u32 mv_crc_update_linear(u32 flags, u32 crc, const u8 *data,
+				unsigned int len)
+{
+	struct dma_chan *chan;
+
+	/* waiting for the engine needs a sleepable, DMA-able caller */
+	if (len < offload_threshold || !(flags & CRYPTO_TFM_REQ_MAY_SLEEP) ||
+	    !virt_addr_valid(data) || !virt_addr_valid(data + len - 1))
+		return __crc32c_le(crc, data, len);
+
+	chan = dma_find_channel(DMA_CRC32C);
+	if (!chan)
+		return __crc32c_le(crc, data, len);
+
+	return mv_crc_offload_linear(chan, crc, data, len);
+}
+
+static int mv_crc_update(struct shash_desc *desc, const u8 *data,
+			 unsigned int length)
+{
+	struct mv_crc_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	ctx->crc = mv_crc_update_linear(desc->flags, ctx->crc, data, length);
+	return 0;
+}
+
+static int mv_crc_final(struct shash_desc *desc, u8 *out)
+{
+	struct mv_crc_desc_ctx *ctx = shash_desc_ctx(desc);
+
+	*(__le32 *)out = ~cpu_to_le32p(&ctx->crc);
+	return 0;
+}
+
+static int mv_crc_finup(struct shash_desc *desc, const u8 *data,
+			unsigned int len, u8 *out)
+{
+	struct mv_crc_desc_ctx *ctx = shash_desc_ctx(desc);
+	u32 crc = mv_crc_update_linear(desc->flags, ctx->crc, data, len);
+
+	*(__le32 *)out = ~cpu_to_le32(crc);
+	return 0;
+}
+
+static int mv_crc_digest(struct shash_desc *desc, const u8 *data,
+			 unsigned int length, u8 *out)
+{
+	struct mv_crc_ctx *mctx = crypto_shash_ctx(desc->tfm);
+	u32 crc = mv_crc_update_linear(desc->flags, mctx->key, data, length);
+
+	*(__le32 *)out = ~cpu_to_le32(crc);
+	return 0;
+}
+
+static int mv_crc_cra_init(struct crypto_tfm *tfm)
+{
+	struct mv_crc_ctx *mctx = crypto_tfm_ctx(tfm);
+
+	mctx->key = ~0;
+	return 0;
+}
+
+static struct shash_alg mv_crc_shash_alg = {
+	.digestsize		=	CHKSUM_DIGEST_SIZE,
+	.setkey			=	mv_crc_setkey,
+	.init			=	mv_crc_init,
+	.update			=	mv_crc_update,
+	.final			=	mv_crc_final,
+	.finup			=	mv_crc_finup,
+	.digest			=	mv_crc_digest,
+	.descsize		=	sizeof(struct mv_crc_desc_ctx),
+	.base			=	{
+		.cra_name		=	"crc32c",
+		.cra_driver_name	=	"crc32c-mv-xor",
+		.cra_priority		=	200,
+		.cra_blocksize		=	CHKSUM_BLOCK_SIZE,
+		.cra_alignmask		=	3,
+		.cra_ctxsize		=	sizeof(struct mv_crc_ctx),
+		.cra_module		=	THIS_MODULE,
+		.cra_init		=	mv_crc_cra_init,
+	}
+};
+
+/*
+ * ahash interface
+ */
+static int mv_crc_ahash_init(struct ahash_request *req)
+{
+	struct mv_crc_ctx *mctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+
+	rctx->crc = mctx->key;
+	return 0;
+}
+
+static int mv_crc_ahash_setkey(struct crypto_ahash *tfm, const u8 *key,
+			       unsigned int keylen)
+{
+	struct mv_crc_ctx *mctx = crypto_ahash_ctx(tfm);
+
+	if (keylen != sizeof(mctx->key)) {
+		crypto_ahash_set_flags(tfm, CRYPTO_TFM_RES_BAD_KEY_LEN);
+		return -EINVAL;
+	}
+	mctx->key = le32_to_cpu(*(__le32 *)key);
+	return 0;
+}
+
+static void mv_crc_ahash_finish(struct mv_crc_req_ctx *rctx)
+{
+	rctx->crc = mv_crc_job_end(&rctx->job, rctx->crc);
+	if (rctx->out)
+		*(__le32 *)rctx->out = ~cpu_to_le32(rctx->crc);
+}
+
+/*
+ * Finished requests are completed from mv_crc_done_tasklet: the job
+ * callback runs from the XOR cleanup path with the channel lock held, and
+ * a client submitting its next request from the completion callback would
+ * deadlock on it.
+ */
+static LIST_HEAD(mv_crc_done);
+static DEFINE_SPINLOCK(mv_crc_done_lock);
+
+static void mv_crc_done_tasklet(unsigned long data)
+{
+	struct mv_crc_req_ctx *rctx, *tmp;
+	unsigned long flags;
+	LIST_HEAD(done);
+
+	spin_lock_irqsave(&mv_crc_done_lock, flags);
+	list_splice_init(&mv_crc_done, &done);
+	spin_unlock_irqrestore(&mv_crc_done_lock, flags);
+
+	list_for_each_entry_safe(rctx, tmp, &done, done_list) {
+		list_del(&rctx->done_list);
+		mv_crc_ahash_finish(rctx);
+		rctx->req->base.complete(&rctx->req->base, 0);
+	}
+}
+
+static DECLARE_TASKLET(mv_crc_done_task, mv_crc_done_tasklet, 0);
+
+static void mv_crc_ahash_done(struct mv_crc_job *job)
+{
+	struct mv_crc_req_ctx *rctx =
+		container_of(job, struct mv_crc_req_ctx, job);
+	unsigned long flags;
+
+	spin_lock_irqsave(&mv_crc_done_lock, flags);
+	list_add_tail(&rctx->done_list, &mv_crc_done);
+	spin_unlock_irqrestore(&mv_crc_done_lock, flags);
+
+	tasklet_schedule(&mv_crc_done_task);
+}
+
+static int mv_crc_ahash_cpu(struct ahash_request *req)
+{
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+	struct crypto_hash_walk walk;
+	int n;
+
+	for (n = crypto_hash_walk_first(req, &walk); n > 0;
+	     n = crypto_hash_walk_done(&walk, 0))
+		rctx->crc = __crc32c_le(rctx->crc, walk.data, n);
+
+	if (n)
+		return n;
+
+	if (rctx->out)
+		*(__le32 *)rctx->out = ~cpu_to_le32(rctx->crc);
+	return 0;
+}
+
+static int mv_crc_ahash_run(struct ahash_request *req, u8 *out)
+{
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+	struct dma_chan *chan = NULL;
+	struct scatterlist *sg;
+	unsigned int nbytes, nsegs, n;
+	gfp_t gfp;
+
+	rctx->out = out;
+	rctx->req = req;
+
+	if (req->nbytes >= offload_threshold)
+		chan = dma_find_channel(DMA_CRC32C);
+	if (!chan)
+		return mv_crc_ahash_cpu(req);
+
+	nsegs = 0;
+	nbytes = req->nbytes;
+	for (sg = req->src; sg && nbytes; sg = sg_next(sg)) {
+		n = min(nbytes, sg->length);
+		nsegs += DIV_ROUND_UP(n, MV_CRC_MAX_HW_LEN);
+		nbytes -= n;
+	}
+
+	gfp = (req->base.flags & CRYPTO_TFM_REQ_MAY_SLEEP) ?
+		GFP_KERNEL : GFP_ATOMIC;
+	if (mv_crc_job_init(&rctx->job, nsegs, gfp))
+		return mv_crc_ahash_cpu(req);
+	rctx->job.complete = mv_crc_ahash_done;
+
+	nbytes = req->nbytes;
+	for (sg = req->src; sg && nbytes; sg = sg_next(sg)) {
+		unsigned int offset = sg->offset;
+		unsigned int len = min(nbytes, sg->length);
+
+		nbytes -= len;
+		while (len) {
+			n = min_t(unsigned int, len, MV_CRC_MAX_HW_LEN);
+			mv_crc_job_add(&rctx->job, chan, sg_page(sg), offset, n);
+			offset += n;
+			len -= n;
+		}
+	}
+
+	if (!mv_crc_job_submit(&rctx->job, chan))
+		return -EINPROGRESS;
+
+	mv_crc_ahash_finish(rctx);
+	return 0;
+}
+
+static int mv_crc_ahash_update(struct ahash_request *req)
+{
+	return mv_crc_ahash_run(req, NULL);
+}
+
+static int mv_crc_ahash_final(struct ahash_request *req)
+{
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+
+	*(__le32 *)req->result = ~cpu_to_le32(rctx->crc);
+	return 0;
+}
+
+static int mv_crc_ahash_finup(struct ahash_request *req)
+{
+	return mv_crc_ahash_run(req, req->result);
+}
+
+static int mv_crc_ahash_digest(struct ahash_request *req)
+{
+	mv_crc_ahash_init(req);
+	return mv_crc_ahash_finup(req);
+}
+
+static int mv_crc_ahash_export(struct ahash_request *req, void *out)
+{
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+
+	memcpy(out, &rctx->crc, sizeof(rctx->crc));
+	return 0;
+}
+
+static int mv_crc_ahash_import(struct ahash_request *req, const void *in)
+{
+	struct mv_crc_req_ctx *rctx = ahash_request_ctx(req);
+
+	memcpy(&rctx->crc, in, sizeof(rctx->crc));
+	return 0;
+}
+
+static int mv_crc_ahash_cra_init(struct crypto_tfm *tfm)
+{
+	crypto_ahash_set_reqsize(__crypto_ahash_cast(tfm),
+				 sizeof(struct mv_crc_req_ctx));
+	return mv_crc_cra_init(tfm);
+}
+
+static struct ahash_alg mv_crc_ahash_alg = {
+	.init			=	mv_crc_ahash_init,
+	.update			=	mv_crc_ahash_update,
+	.final			=	mv_crc_ahash_final,
+	.finup			=	mv_crc_ahash_finup,
+	.digest			=	mv_crc_ahash_digest,
+	.export			=	mv_crc_ahash_export,
+	.import			=	mv_crc_ahash_import,
+	.setkey			=	mv_crc_ahash_setkey,
+	.halg			=	{
+		.digestsize		=	CHKSUM_DIGEST_SIZE,
+		.statesize		=	sizeof(u32),
+		.base			=	{
+			.cra_name		=	"crc32c",
+			.cra_driver_name	=	"crc32c-mv-xor-async",
+			.cra_priority		=	300,
+			.cra_flags		=	CRYPTO_ALG_TYPE_AHASH |
+							CRYPTO_ALG_ASYNC,
+			.cra_blocksize		=	CHKSUM_BLOCK_SIZE,
+			.cra_alignmask		=	3,
+			.cra_ctxsize		=	sizeof(struct mv_crc_ctx),
+			.cra_type		=	&crypto_ahash_type,
+			.cra_module		=	THIS_MODULE,
+			.cra_init		=	mv_crc_ahash_cra_init,
+		}
+	}
+};
+
+static int __init mv_crc_mod_init(void)
+{
+	int ret;
+
+	mv_crc_shift_init();
+
+	/* makes DMA_CRC32C channels visible through dma_find_channel() */
+	dmaengine_get();
+
+	ret = crypto_register_shash(&mv_crc_shash_alg);
+	if (ret)
+		goto err_put;
+
+	ret = crypto_register_ahash(&mv_crc_ahash_alg);
+	if (ret)
+		goto err_shash;
+
+	return 0;
+
+err_shash:
+	crypto_unregister_shash(&mv_crc_shash_alg);
+err_put:
+	dmaengine_put();
+	return ret;
+}
+
+static void __exit mv_crc_mod_fini(void)
+{
+	crypto_unregister_ahash(&mv_crc_ahash_alg);
+	crypto_unregister_shash(&mv_crc_shash_alg);
+	tasklet_kill(&mv_crc_done_task);
+	dmaengine_put();
+}
+
+module_init(mv_crc_mod_init);
+module_exit(mv_crc_mod_fini);
+
+MODULE_DESCRIPTION("CRC32c offload on the Marvell XOR engine");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS_CRYPTO("crc32c");
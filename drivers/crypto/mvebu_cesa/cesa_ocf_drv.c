@@ -425,7 +425,9 @@ cesa_ocf_process(device_t dev, struct cryptop *crp, int hint)
 		dprintk("%s,%d: handle UIO.\n", __FILE__, __LINE__);
 		uiop = (struct uio *) crp->crp_buf;
 
-                if (uiop->uio_iovcnt > (MV_CESA_MAX_MBUF_FRAGS - 1)) {
+		/* first 2 fragments are reserved for IV and digest, zero-copy
+		 * requests from cryptodev come in one fragment per user page */
+                if (uiop->uio_iovcnt > (MV_CESA_MAX_MBUF_FRAGS - 2)) {
                         printk("%s,%d: %d uio_iovcnt > MV_CESA_MAX_MBUF_FRAGS \n", __FILE__, __LINE__, uiop->uio_iovcnt);
                         goto p_error;
                 }
@@ -344,6 +344,113 @@ struct dma_chan *dma_find_channel(enum dma_transaction_type tx_type)
 }
 EXPORT_SYMBOL(dma_find_channel);
 
+#ifdef CONFIG_ASYNC_TX_CHANNEL_BALANCE
+/**
+ * balance_table - every public channel per operation type
+ *
+ * channel_table pins each cpu to one channel per operation, so a two cpu
+ * system never uses more than two of the available XOR channels.  Clients
+ * that would rather spread independent work over every channel look it
+ * up here instead.  Updated under dma_list_mutex by dma_channel_rebalance.
+ */
+#define DMA_BALANCE_MAX_CHANS	8
+
+struct dma_balance_ent {
+	struct dma_chan *chan[DMA_BALANCE_MAX_CHANS];
+	int count;
+	unsigned int next;
+};
+
+static struct dma_balance_ent balance_table[DMA_TX_TYPE_END];
+
+static void dma_balance_table_update(void)
+{
+	struct dma_balance_ent *ent;
+	struct dma_device *device;
+	struct dma_chan *chan;
+	int cap, n;
+
+	for_each_dma_cap_mask(cap, dma_cap_mask_all) {
+		ent = &balance_table[cap];
+		n = 0;
+
+		/* readers never look past count, shrink it first */
+		ent->count = 0;
+		smp_wmb();
+
+		if (!dmaengine_ref_count)
+			continue;
+
+		list_for_each_entry(device, &dma_device_list, global_node) {
+			if (!dma_has_cap(cap, device->cap_mask) ||
+			    dma_has_cap(DMA_PRIVATE, device->cap_mask))
+				continue;
+			list_for_each_entry(chan, &device->channels,
+					    device_node) {
+				if (chan->client_count &&
+				    n < DMA_BALANCE_MAX_CHANS)
+					ent->chan[n++] = chan;
+			}
+		}
+
+		smp_wmb();
+		ent->count = n;
+	}
+}
+
+/* descriptors submitted to the channel but not yet cleaned up */
+static inline int dma_chan_queue_depth(struct dma_chan *chan)
+{
+	int depth = ACCESS_ONCE(chan->cookie) -
+		ACCESS_ONCE(chan->completed_cookie);
+
+	/* cookies restart at DMA_MIN_COOKIE when they wrap */
+	return depth < 0 ? 0 : depth;
+}
+
+/**
+ * dma_find_channel_balanced - find the least busy channel for an operation
+ * @tx_type: transaction type
+ *
+ * Scans every public channel capable of @tx_type, starting at a rotating
+ * position so that equally loaded channels are used round-robin, and
+ * returns the one with the fewest outstanding descriptors.
+ */
+struct dma_chan *dma_find_channel_balanced(enum dma_transaction_type tx_type)
+{
+	struct dma_balance_ent *ent = &balance_table[tx_type];
+	struct dma_chan *chan, *best = NULL;
+	int count = ACCESS_ONCE(ent->count);
+	int i, depth, best_depth = INT_MAX;
+	unsigned int start;
+
+	if (count <= 1)
+		return dma_find_channel(tx_type);
+
+	smp_rmb();
+	/* racy by design, it only spreads the starting point */
+	start = ent->next++;
+
+	for (i = 0; i < count; i++) {
+		chan = ent->chan[(start + i) % count];
+		depth = dma_chan_queue_depth(chan);
+		if (depth < best_depth) {
+			best = chan;
+			best_depth = depth;
+			if (!depth)
+				break;
+		}
+	}
+
+	return best;
+}
+EXPORT_SYMBOL(dma_find_channel_balanced);
+#else
+static inline void dma_balance_table_update(void)
+{
+}
+#endif /* CONFIG_ASYNC_TX_CHANNEL_BALANCE */
+
 /*
  * net_dma_find_channel - find a channel for net_dma
  * net_dma has alignment requirements
@@ -452,6 +559,8 @@ static void dma_channel_rebalance(void)
 			chan->table_count = 0;
 	}
 
+	dma_balance_table_update();
+
 	/* don't populate the channel_table if no clients are available */
 	if (!dmaengine_ref_count)
 		return;
@@ -19,6 +19,8 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/spinlock.h>
@@ -36,6 +38,11 @@
 #include "dmaengine.h"
 #include "mv_xor.h"
 
+static unsigned int poll_usecs;
+module_param(poll_usecs, uint, 0644);
+MODULE_PARM_DESC(poll_usecs,
+		 "Time in usecs tx_status spins on an incomplete cookie (default: 0)");
+
 unsigned int dummy1[MV_XOR_MIN_BYTE_COUNT];
 unsigned int dummy2[MV_XOR_MIN_BYTE_COUNT];
 dma_addr_t dummy1_addr, dummy2_addr;
@@ -429,6 +436,22 @@ mv_xor_run_tx_complete_actions(struct mv_xor_desc_slot *desc,
 	return cookie;
 }
 
+/*
+ * mv_xor_free_slot - give a slot back to the allocator
+ * Caller must hold &mv_chan->lock, which makes it the only producer of
+ * the free ring; allocation consumes it without the lock.
+ */
+static void mv_xor_free_slot(struct mv_xor_chan *mv_chan,
+			     struct mv_xor_desc_slot *slot)
+{
+	unsigned int tail = mv_chan->free_tail;
+
+	list_del_init(&slot->node);
+	mv_chan->free_ring[tail & mv_chan->free_ring_mask] = slot->idx;
+	smp_wmb();
+	ACCESS_ONCE(mv_chan->free_tail) = tail + 1;
+}
+
 static int
 mv_xor_clean_completed_slots(struct mv_xor_chan *mv_chan)
 {
@@ -439,7 +462,7 @@ mv_xor_clean_completed_slots(struct mv_xor_chan *mv_chan)
 				 node) {
 
 		if (async_tx_test_ack(&iter->async_tx))
-			list_move_tail(&iter->node, &mv_chan->free_slots);
+			mv_xor_free_slot(mv_chan, iter);
 	}
 	return 0;
 }
@@ -451,6 +474,8 @@ mv_xor_clean_slot(struct mv_xor_desc_slot *desc,
 	dev_dbg(mv_chan_to_devp(mv_chan), "%s %d: desc %p flags %d\n",
 		__func__, __LINE__, desc, desc->async_tx.flags);
 
+	desc->in_chain = 0;
+
 	/* the client is allowed to attach dependent operations
 	 * until 'ack' is set
 	 */
@@ -458,19 +483,73 @@ mv_xor_clean_slot(struct mv_xor_desc_slot *desc,
 		/* move this slot to the completed_slots */
 		list_move_tail(&desc->node, &mv_chan->completed_slots);
 	else
-		list_move_tail(&desc->node, &mv_chan->free_slots);
+		mv_xor_free_slot(mv_chan, desc);
 
 	return 0;
 }
 
+static inline int mv_xor_desc_done(struct mv_xor_desc_slot *desc)
+{
+	struct mv_xor_desc *hw_desc = desc->hw_desc;
+
+	return hw_desc->status & XOR_DESC_SUCCESS ? 1 : 0;
+}
+
+static struct mv_xor_desc_slot *
+mv_xor_phys_to_slot(struct mv_xor_chan *mv_chan, u32 phys)
+{
+	u32 offset = phys - mv_chan->dma_desc_pool;
+
+	if (phys < mv_chan->dma_desc_pool ||
+	    offset >= mv_chan->slots_allocated * MV_XOR_SLOT_SIZE)
+		return NULL;
+
+	return &mv_chan->slots[offset / MV_XOR_SLOT_SIZE];
+}
+
+/*
+ * mv_xor_last_completed - find the newest completed descriptor on the chain
+ *
+ * The engine runs the chain strictly in order, so the chain is always a
+ * run of completed descriptors followed by pending ones.  The current
+ * descriptor register points at the boundary: either it is done itself
+ * or its predecessor is.  That costs at most two status reads per
+ * cleanup; the chain is only scanned when the register is stale, e.g.
+ * the slot it points at was recycled before the engine got to it.
+ * Caller must hold &mv_chan->lock.
+ */
+static struct mv_xor_desc_slot *
+mv_xor_last_completed(struct mv_xor_chan *mv_chan, u32 current_desc)
+{
+	struct mv_xor_desc_slot *cur, *prev, *iter, *last = NULL;
+
+	cur = mv_xor_phys_to_slot(mv_chan, current_desc);
+	if (cur && cur->in_chain) {
+		if (mv_xor_desc_done(cur))
+			return cur;
+		if (cur->node.prev == &mv_chan->chain)
+			return NULL;
+		prev = list_entry(cur->node.prev, struct mv_xor_desc_slot,
+				  node);
+		if (mv_xor_desc_done(prev))
+			return prev;
+	}
+
+	list_for_each_entry(iter, &mv_chan->chain, node) {
+		if (!mv_xor_desc_done(iter))
+			break;
+		last = iter;
+	}
+
+	return last;
+}
+
 static void __mv_xor_slot_cleanup(struct mv_xor_chan *mv_chan)
 {
-	struct mv_xor_desc_slot *iter, *_iter;
+	struct mv_xor_desc_slot *iter, *_iter, *last_done, *cur;
 	dma_cookie_t cookie = 0;
 	int busy = mv_chan_is_busy(mv_chan);
 	u32 current_desc = mv_chan_get_current_desc(mv_chan);
-	int current_cleaned = 0;
-	struct mv_xor_desc *hw_desc;
 	struct dma_chan *dma_chan;
 	dma_chan = &mv_chan->dmachan;
 
@@ -486,14 +565,12 @@ static void __mv_xor_slot_cleanup(struct mv_xor_chan *mv_chan)
 	mv_xor_clean_completed_slots(mv_chan);
 
 	/* free completed slots from the chain starting with
-	 * the oldest descriptor
+	 * the oldest descriptor, in one batch up to last_done
 	 */
-
-	list_for_each_entry_safe(iter, _iter, &mv_chan->chain,
-				 node) {
-		/* clean finished descriptors */
-		hw_desc = iter->hw_desc;
-		if (hw_desc->status & XOR_DESC_SUCCESS) {
+	last_done = mv_xor_last_completed(mv_chan, current_desc);
+	if (last_done) {
+		list_for_each_entry_safe(iter, _iter, &mv_chan->chain,
+					 node) {
 			if (iter->type == DMA_CRC32C) {
 				struct mv_xor_desc *hw_desc = iter->hw_desc;
 				BUG_ON(!iter->crc32_result);
@@ -505,30 +582,23 @@ static void __mv_xor_slot_cleanup(struct mv_xor_chan *mv_chan)
 			/* done processing desc, clean slot */
 			mv_xor_clean_slot(iter, mv_chan);
 
-			/* break if we did cleaned the current */
-			if (iter->async_tx.phys == current_desc) {
-				current_cleaned = 1;
+			if (iter == last_done)
 				break;
-			}
-		} else {
-			if (iter->async_tx.phys == current_desc) {
-				current_cleaned = 0;
-				break;
-			}
 		}
 	}
 
 	if ((busy == 0) && !list_empty(&mv_chan->chain)) {
-		if (current_cleaned) {
+		cur = mv_xor_phys_to_slot(mv_chan, current_desc);
+		if (!cur || !cur->in_chain) {
 			/* current descriptor cleaned and removed, run from list head */
 			iter = list_entry(mv_chan->chain.next,
 						struct mv_xor_desc_slot,
 						node);
 			mv_xor_start_new_chain(mv_chan, iter);
 		} else {
-			if (!list_is_last(&iter->node, &mv_chan->chain)) {
+			if (!list_is_last(&cur->node, &mv_chan->chain)) {
 				/* descriptors are still waiting after current, trigger them */
-				iter = list_entry(iter->node.next, struct mv_xor_desc_slot, node);
+				iter = list_entry(cur->node.next, struct mv_xor_desc_slot, node);
 				mv_xor_start_new_chain(mv_chan, iter);
 			} else {
 				/* some descriptors are still waiting to be cleaned */
@@ -555,34 +625,35 @@ static void mv_xor_tasklet(unsigned long data)
 	mv_xor_slot_cleanup(chan);
 }
 
+/*
+ * mv_xor_alloc_slot - take a slot from the free ring
+ * Lockless: allocators race on free_head with cmpxchg, a slot index is
+ * only read before the cmpxchg that claims it succeeds.
+ */
 static struct mv_xor_desc_slot *mv_xor_alloc_slot(struct mv_xor_chan *mv_chan)
 {
 	struct mv_xor_desc_slot *iter;
+	unsigned int head;
+	u16 idx;
+
+	do {
+		head = ACCESS_ONCE(mv_chan->free_head);
+		if (head == ACCESS_ONCE(mv_chan->free_tail)) {
+			/* try to free some slots if the allocation fails */
+			tasklet_schedule(&mv_chan->irq_tasklet);
+			return NULL;
+		}
+		smp_rmb();
+		idx = mv_chan->free_ring[head & mv_chan->free_ring_mask];
+	} while (cmpxchg(&mv_chan->free_head, head, head + 1) != head);
 
-	spin_lock_bh(&mv_chan->lock);
-
-	if (!list_empty(&mv_chan->free_slots)) {
-		iter = list_first_entry(&mv_chan->free_slots,
-					struct mv_xor_desc_slot,
-					node);
-
-		list_move_tail(&iter->node, &mv_chan->allocated_slots);
-
-		spin_unlock_bh(&mv_chan->lock);
-
-		/* pre-ack descriptor */
-		async_tx_ack(&iter->async_tx);
-		iter->async_tx.cookie = -EBUSY;
-
-		return iter;
-	}
-
-	spin_unlock_bh(&mv_chan->lock);
+	iter = &mv_chan->slots[idx];
 
-	/* try to free some slots if the allocation fails */
-	tasklet_schedule(&mv_chan->irq_tasklet);
+	/* pre-ack descriptor */
+	async_tx_ack(&iter->async_tx);
+	iter->async_tx.cookie = -EBUSY;
 
-	return NULL;
+	return iter;
 }
 
 /************************ DMA engine API functions ****************************/
@@ -603,15 +674,16 @@ mv_xor_tx_submit(struct dma_async_tx_descriptor *tx)
 	spin_lock_bh(&mv_chan->lock);
 	cookie = dma_cookie_assign(tx);
 
+	sw_desc->in_chain = 1;
 	if (list_empty(&mv_chan->chain))
-		list_move_tail(&sw_desc->node, &mv_chan->chain);
+		list_add_tail(&sw_desc->node, &mv_chan->chain);
 	else {
 		new_hw_chain = 0;
 
 		old_chain_tail = list_entry(mv_chan->chain.prev,
 					    struct mv_xor_desc_slot,
 					    node);
-		list_move_tail(&sw_desc->node, &mv_chan->chain);
+		list_add_tail(&sw_desc->node, &mv_chan->chain);
 
 		dev_dbg(mv_chan_to_devp(mv_chan), "Append to last desc %x\n",
 			old_chain_tail->async_tx.phys);
@@ -645,18 +717,25 @@ static int mv_xor_alloc_chan_resources(struct dma_chan *chan)
 	char *hw_desc;
 	int idx;
 	struct mv_xor_chan *mv_chan = to_mv_xor_chan(chan);
-	struct mv_xor_desc_slot *slot = NULL;
+	struct mv_xor_desc_slot *slots, *slot;
 	int num_descs_in_pool = MV_XOR_POOL_SIZE/MV_XOR_SLOT_SIZE;
+	unsigned int ring_size = roundup_pow_of_two(num_descs_in_pool);
+	u16 *ring;
+
+	if (mv_chan->slots_allocated)
+		return mv_chan->slots_allocated;
 
 	/* Allocate descriptor slots */
-	idx = mv_chan->slots_allocated;
-	while (idx < num_descs_in_pool) {
-		slot = kzalloc(sizeof(*slot), GFP_KERNEL);
-		if (!slot) {
-			printk(KERN_INFO "MV XOR Channel only initialized"
-				" %d descriptor slots", idx);
-			break;
-		}
+	slots = vzalloc(num_descs_in_pool * sizeof(*slots));
+	ring = kcalloc(ring_size, sizeof(*ring), GFP_KERNEL);
+	if (!slots || !ring) {
+		vfree(slots);
+		kfree(ring);
+		return -ENOMEM;
+	}
+
+	for (idx = 0; idx < num_descs_in_pool; idx++) {
+		slot = &slots[idx];
 		hw_desc = (char *) mv_chan->dma_desc_pool_virt;
 		slot->hw_desc = (void *) &hw_desc[idx * MV_XOR_SLOT_SIZE];
 
@@ -666,19 +745,24 @@ static int mv_xor_alloc_chan_resources(struct dma_chan *chan)
 		hw_desc = (char *) mv_chan->dma_desc_pool;
 		slot->async_tx.phys =
 			(dma_addr_t) &hw_desc[idx * MV_XOR_SLOT_SIZE];
-		slot->idx = idx++;
-
-		spin_lock_bh(&mv_chan->lock);
-		mv_chan->slots_allocated = idx;
-		list_add_tail(&slot->node, &mv_chan->free_slots);
-		spin_unlock_bh(&mv_chan->lock);
+		slot->idx = idx;
+		ring[idx] = idx;
 	}
 
+	spin_lock_bh(&mv_chan->lock);
+	mv_chan->slots = slots;
+	mv_chan->free_ring = ring;
+	mv_chan->free_ring_mask = ring_size - 1;
+	mv_chan->free_head = 0;
+	mv_chan->free_tail = num_descs_in_pool;
+	mv_chan->slots_allocated = num_descs_in_pool;
+	spin_unlock_bh(&mv_chan->lock);
+
 	dev_dbg(mv_chan_to_devp(mv_chan),
 		"allocated %d descriptor slots\n",
 		mv_chan->slots_allocated);
 
-	return mv_chan->slots_allocated ? : -ENOMEM;
+	return mv_chan->slots_allocated;
 }
 
 static struct dma_async_tx_descriptor *
@@ -889,38 +973,34 @@ mv_xor_prep_dma_pq(struct dma_chan *chan, dma_addr_t *dst, dma_addr_t *src,
 static void mv_xor_free_chan_resources(struct dma_chan *chan)
 {
 	struct mv_xor_chan *mv_chan = to_mv_xor_chan(chan);
-	struct mv_xor_desc_slot *iter, *_iter;
-	int in_use_descs = 0;
+	struct mv_xor_desc_slot *slots;
+	u16 *ring;
+	int in_use_descs;
+
+	if (!mv_chan->slots_allocated)
+		return;
 
 	mv_xor_slot_cleanup(mv_chan);
 
 	spin_lock_bh(&mv_chan->lock);
-	list_for_each_entry_safe(iter, _iter, &mv_chan->chain,
-					node) {
-		in_use_descs++;
-		list_move_tail(&iter->node, &mv_chan->free_slots);
-	}
-	list_for_each_entry_safe(iter, _iter, &mv_chan->completed_slots,
-				 node) {
-		in_use_descs++;
-		list_move_tail(&iter->node, &mv_chan->free_slots);
-	}
-	list_for_each_entry_safe(iter, _iter, &mv_chan->allocated_slots,
-				 node) {
-		in_use_descs++;
-		list_move_tail(&iter->node, &mv_chan->free_slots);
-	}
-	list_for_each_entry_safe_reverse(
-		iter, _iter, &mv_chan->free_slots, node) {
-		list_del(&iter->node);
-		kfree(iter);
-		mv_chan->slots_allocated--;
-	}
+	in_use_descs = mv_chan->slots_allocated -
+		(mv_chan->free_tail - mv_chan->free_head);
+	INIT_LIST_HEAD(&mv_chan->chain);
+	INIT_LIST_HEAD(&mv_chan->completed_slots);
+	slots = mv_chan->slots;
+	ring = mv_chan->free_ring;
+	mv_chan->slots = NULL;
+	mv_chan->free_ring = NULL;
+	mv_chan->free_head = mv_chan->free_tail = 0;
+	mv_chan->slots_allocated = 0;
 
 	dev_dbg(mv_chan_to_devp(mv_chan), "%s slots_allocated %d\n",
 		__func__, mv_chan->slots_allocated);
 	spin_unlock_bh(&mv_chan->lock);
 
+	vfree(slots);
+	kfree(ring);
+
 	if (in_use_descs)
 		dev_err(mv_chan_to_devp(mv_chan),
 			"freeing %d in use descriptors!\n", in_use_descs);
@@ -938,6 +1018,7 @@ static enum dma_status mv_xor_status(struct dma_chan *chan,
 {
 	struct mv_xor_chan *mv_chan = to_mv_xor_chan(chan);
 	enum dma_status ret;
+	unsigned int usecs;
 
 	ret = dma_cookie_status(chan, cookie, txstate);
 	if (ret == DMA_SUCCESS) {
@@ -947,8 +1028,18 @@ static enum dma_status mv_xor_status(struct dma_chan *chan,
 		return ret;
 	}
 	mv_xor_slot_cleanup(mv_chan);
+	ret = dma_cookie_status(chan, cookie, txstate);
+
+	/* latency sensitive clients may spin for completion instead of
+	 * waiting for the end-of-chain interrupt and tasklet
+	 */
+	for (usecs = poll_usecs; ret != DMA_SUCCESS && usecs; usecs--) {
+		udelay(1);
+		mv_xor_slot_cleanup(mv_chan);
+		ret = dma_cookie_status(chan, cookie, txstate);
+	}
 
-	return dma_cookie_status(chan, cookie, txstate);
+	return ret;
 }
 
 static void mv_dump_xor_regs(struct mv_xor_chan *chan)
@@ -1381,8 +1472,6 @@ mv_xor_channel_add(struct mv_xor_device *xordev,
 	spin_lock_init(&mv_chan->lock);
 	INIT_LIST_HEAD(&mv_chan->chain);
 	INIT_LIST_HEAD(&mv_chan->completed_slots);
-	INIT_LIST_HEAD(&mv_chan->free_slots);
-	INIT_LIST_HEAD(&mv_chan->allocated_slots);
 	mv_chan->dmachan.device = dma_dev;
 	dma_cookie_init(&mv_chan->dmachan);
 
@@ -1547,6 +1636,16 @@ static int mv_xor_probe(struct platform_device *pdev)
 			if (of_property_read_bool(np, "dmacap,pq"))
 				dma_cap_set(DMA_PQ, cap_mask);
 
+			/*
+			 * In descriptor mode any channel can queue the
+			 * interrupt descriptor async_tx uses to hand a
+			 * dependency over to another channel; without it
+			 * async_tx falls back to polling on the CPU.
+			 */
+			if (op_in_desc == XOR_MODE_IN_DESC &&
+			    !bitmap_empty(cap_mask.bits, DMA_TX_TYPE_END))
+				dma_cap_set(DMA_INTERRUPT, cap_mask);
+
 			irq = irq_of_parse_and_map(np, 0);
 			if (!irq) {
 				ret = -ENODEV;
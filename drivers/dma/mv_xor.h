@@ -86,9 +86,12 @@ struct mv_xor_suspend_regs {
  * @mmr_base: memory mapped register base
  * @idx: the index of the xor channel
  * @chain: device chain view of the descriptors
- * @free_slots: free slots usable by the channel
- * @allocated_slots: slots allocated by the driver
  * @completed_slots: slots completed by HW but still need to be acked
+ * @slots: all descriptor slots, indexed by slot->idx
+ * @free_ring: indices of the free slots, a FIFO between free_head/free_tail
+ * @free_ring_mask: size of free_ring minus one, free_ring is a power of 2
+ * @free_head: next free index to allocate, advanced locklessly by cmpxchg
+ * @free_tail: next position to release a slot to, updated under @lock
  * @device: parent device
  * @common: common dmaengine channel object members
  * @slots_allocated: records the actual size of the descriptor slot pool
@@ -104,9 +107,12 @@ struct mv_xor_chan {
 	enum dma_transaction_type	current_type;
 	struct mv_xor_suspend_regs	suspend_regs;
 	struct list_head	chain;
-	struct list_head	free_slots;
-	struct list_head	allocated_slots;
 	struct list_head	completed_slots;
+	struct mv_xor_desc_slot	*slots;
+	u16			*free_ring;
+	unsigned int		free_ring_mask;
+	unsigned int		free_head;
+	unsigned int		free_tail;
 	dma_addr_t		dma_desc_pool;
 	void			*dma_desc_pool_virt;
 	size_t                  pool_size;
@@ -128,6 +134,7 @@ struct mv_xor_chan {
  * @phys: hardware address of the hardware descriptor chain
  * @slot_used: slot in use or not
  * @idx: pool index
+ * @in_chain: slot is on the channel's hardware chain
  * @unmap_src_cnt: number of xor sources
  * @unmap_len: transaction bytecount
  * @async_tx: support for the async_tx api
@@ -140,6 +147,7 @@ struct mv_xor_desc_slot {
 	void			*hw_desc;
 	u16			idx;
 	u16			unmap_src_cnt;
+	u8			in_chain;
 	u32			value;
 	size_t			unmap_len;
 	struct dma_async_tx_descriptor	async_tx;
@@ -0,0 +1,228 @@
+/*
+ * Page copy and clear offload to a dmaengine memcpy channel
+ *
+ * Page migration, compaction and huge page copy/clear hand large runs of
+ * physically contiguous pages to the public DMA_MEMCPY channel that
+ * dma_find_channel() picks for this CPU, the same way async_tx does, so
+ * the descriptors simply queue behind those of other clients.  The run
+ * is split into OFFLOAD_CHUNK descriptors, the last one of which signals
+ * a completion from its callback: the caller sleeps instead of spinning
+ * on the CPU it wants to save.  Clearing copies from a zeroed buffer, as
+ * memcpy channels have no memset.
+ *
+ * Only channels which also have DMA_INTERRUPT are used, a channel which
+ * cannot raise a completion interrupt would never run the callback.
+ * When there is no such channel, another offload is running, or a
+ * descriptor cannot be prepared, the caller does the copy on the CPU.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+#include <linux/completion.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/dma_page_offload.h>
+#include <linux/hardirq.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+
+#define OFFLOAD_CHUNK	(64 * 1024)
+
+/* serializes offloads and enable/disable */
+static DEFINE_MUTEX(offload_lock);
+/* OFFLOAD_CHUNK zero bytes, allocated while enabled */
+static void *offload_zero;
+
+static unsigned int min_pages = 16;
+module_param(min_pages, uint, 0644);
+MODULE_PARM_DESC(min_pages,
+		 "Smallest copy in pages handed to the engine (default: 16)");
+
+static bool enable;
+/* set once the late initcall has run, mm and dmaengine are up by then */
+static bool offload_ready;
+
+/* take or drop the zero buffer and channel reference to match enable */
+static int offload_update(void)
+{
+	if (enable == !!offload_zero)
+		return 0;
+
+	if (enable) {
+		offload_zero = kzalloc(OFFLOAD_CHUNK, GFP_KERNEL);
+		if (!offload_zero) {
+			enable = false;
+			return -ENOMEM;
+		}
+		/* makes the public channels visible to dma_find_channel() */
+		dmaengine_get();
+	} else {
+		dmaengine_put();
+		kfree(offload_zero);
+		offload_zero = NULL;
+	}
+	return 0;
+}
+
+static int offload_set_enable(const char *val, const struct kernel_param *kp)
+{
+	int ret;
+
+	/* page_offload.enable= on the command line: only record it */
+	if (!offload_ready)
+		return param_set_bool(val, kp);
+
+	mutex_lock(&offload_lock);
+	ret = param_set_bool(val, kp);
+	if (!ret)
+		ret = offload_update();
+	mutex_unlock(&offload_lock);
+	return ret;
+}
+
+static struct kernel_param_ops offload_enable_ops = {
+	.set	= offload_set_enable,
+	.get	= param_get_bool,
+};
+module_param_cb(enable, &offload_enable_ops, &enable, 0644);
+MODULE_PARM_DESC(enable,
+		 "Offload page migration copies and huge page clearing (default: 0)");
+
+static void offload_done(void *arg)
+{
+	complete(arg);
+}
+
+/* @src == NULL clears @dst */
+static int offload_pages(struct page *dst, struct page *src,
+			 unsigned int nr_pages)
+{
+	enum dma_ctrl_flags flags = DMA_CTRL_ACK | DMA_COMPL_SKIP_SRC_UNMAP |
+				    DMA_COMPL_SKIP_DEST_UNMAP;
+	size_t len = (size_t)nr_pages << PAGE_SHIFT;
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct dma_async_tx_descriptor *tx;
+	dma_cookie_t cookie = 0;
+	dma_addr_t dst_dma, src_dma;
+	struct dma_chan *chan;
+	struct device *dev;
+	size_t off, n;
+	int ret = 0;
+
+	if (!enable || nr_pages < min_pages)
+		return -ENODEV;
+
+	if (in_interrupt() || !mutex_trylock(&offload_lock))
+		return -EBUSY;
+
+	/* not set up yet, or disabled before we got the lock */
+	chan = offload_zero ? dma_find_channel(DMA_MEMCPY) : NULL;
+	if (!chan || !dma_has_cap(DMA_INTERRUPT, chan->device->cap_mask)) {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	dev = chan->device->dev;
+	dst_dma = dma_map_page(dev, dst, 0, len, DMA_FROM_DEVICE);
+	if (dma_mapping_error(dev, dst_dma)) {
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	if (src)
+		src_dma = dma_map_page(dev, src, 0, len, DMA_TO_DEVICE);
+	else
+		src_dma = dma_map_single(dev, offload_zero, OFFLOAD_CHUNK,
+					 DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, src_dma)) {
+		ret = -ENOMEM;
+		goto out_unmap_dst;
+	}
+
+	for (off = 0; off < len; off += n) {
+		n = min_t(size_t, len - off, OFFLOAD_CHUNK);
+		if (off + n == len)
+			flags |= DMA_PREP_INTERRUPT;
+
+		tx = chan->device->device_prep_dma_memcpy(chan, dst_dma + off,
+				src ? src_dma + off : src_dma, n, flags);
+		if (!tx) {
+			ret = -ENOMEM;
+			break;
+		}
+		if (off + n == len) {
+			tx->callback = offload_done;
+			tx->callback_param = &done;
+		}
+
+		cookie = dmaengine_submit(tx);
+		if (dma_submit_error(cookie)) {
+			ret = -EIO;
+			break;
+		}
+	}
+
+	dma_async_issue_pending(chan);
+	if (!ret)
+		wait_for_completion(&done);
+	else if (cookie > 0)
+		/* only on errors: wait for what went out before unmapping */
+		dma_sync_wait(chan, cookie);
+
+	if (src)
+		dma_unmap_page(dev, src_dma, len, DMA_TO_DEVICE);
+	else
+		dma_unmap_single(dev, src_dma, OFFLOAD_CHUNK, DMA_TO_DEVICE);
+out_unmap_dst:
+	dma_unmap_page(dev, dst_dma, len, DMA_FROM_DEVICE);
+out_unlock:
+	mutex_unlock(&offload_lock);
+	return ret;
+}
+
+static int __init offload_init(void)
+{
+	int ret;
+
+	mutex_lock(&offload_lock);
+	offload_ready = true;
+	ret = offload_update();
+	mutex_unlock(&offload_lock);
+	return ret;
+}
+late_initcall(offload_init);
+
+/**
+ * dma_offload_copy_pages - copy physically contiguous pages on a DMA engine
+ * @dst: first destination page
+ * @src: first source page
+ * @nr_pages: number of pages
+ *
+ * Returns 0 when the pages were copied, an error when the caller has to
+ * copy them itself.  May sleep.
+ */
+int dma_offload_copy_pages(struct page *dst, struct page *src,
+			   unsigned int nr_pages)
+{
+	return offload_pages(dst, src, nr_pages);
+}
+
+/**
+ * dma_offload_clear_pages - zero physically contiguous pages on a DMA engine
+ * @page: first page
+ * @nr_pages: number of pages
+ *
+ * Returns 0 when the pages were cleared, an error when the caller has to
+ * clear them itself.  May sleep.
+ */
+int dma_offload_clear_pages(struct page *page, unsigned int nr_pages)
+{
+	return offload_pages(page, NULL, nr_pages);
+}
@@ -81,6 +81,8 @@ static struct irq_domain *armada_370_xp_msi_domain;
 static DECLARE_BITMAP(msi_used, PCI_MSI_DOORBELL_NR);
 static DEFINE_MUTEX(msi_used_lock);
 static phys_addr_t msi_doorbell_addr;
+/* CPUs that have the MSI doorbells unmasked and may be targeted */
+static struct cpumask msi_cpus;
 #endif
 
 /*
@@ -148,16 +150,19 @@ static void armada_370_xp_irq_unmask(struct irq_data *d)
 
 #ifdef CONFIG_PCI_MSI
 
-static int armada_370_xp_alloc_msi(void)
+/*
+ * Allocate a naturally aligned block of 2^order doorbells, as required
+ * by multiple message MSI where the device ORs the vector number into
+ * the low bits of the message data.
+ */
+static int armada_370_xp_alloc_msi(int order)
 {
 	int hwirq;
 
 	mutex_lock(&msi_used_lock);
-	hwirq = find_first_zero_bit(&msi_used, PCI_MSI_DOORBELL_NR);
-	if (hwirq >= PCI_MSI_DOORBELL_NR)
+	hwirq = bitmap_find_free_region(msi_used, PCI_MSI_DOORBELL_NR, order);
+	if (hwirq < 0)
 		hwirq = -ENOSPC;
-	else
-		set_bit(hwirq, msi_used);
 	mutex_unlock(&msi_used_lock);
 
 	return hwirq;
@@ -173,15 +178,35 @@ static void armada_370_xp_free_msi(int hwirq)
 	mutex_unlock(&msi_used_lock);
 }
 
+/*
+ * The doorbell is raised through the software trigger register, whose
+ * bits 8-11 select the target CPUs. Each vector is sent to exactly one
+ * CPU, since the doorbell cause register is banked per CPU and every
+ * CPU that has it unmasked would otherwise handle the same MSI.
+ */
+static u32 armada_370_xp_msi_data(irq_hw_number_t hwirq, int cpu)
+{
+	return (1 << (cpu_logical_map(cpu) + 8)) |
+		(hwirq + PCI_MSI_DOORBELL_START);
+}
+
+static void armada_370_xp_compose_msi_msg(irq_hw_number_t hwirq,
+					  struct msi_msg *msg)
+{
+	msg->address_lo = msi_doorbell_addr;
+	msg->address_hi = 0;
+	msg->data = armada_370_xp_msi_data(hwirq,
+					   cpumask_first(&msi_cpus));
+}
+
 static int armada_370_xp_setup_msi_irq(struct msi_chip *chip,
 				       struct pci_dev *pdev,
 				       struct msi_desc *desc)
 {
 	struct msi_msg msg;
-	irq_hw_number_t hwirq;
-	int virq;
+	int hwirq, virq;
 
-	hwirq = armada_370_xp_alloc_msi();
+	hwirq = armada_370_xp_alloc_msi(0);
 	if (hwirq < 0)
 		return hwirq;
 
@@ -193,12 +218,50 @@ static int armada_370_xp_setup_msi_irq(struct msi_chip *chip,
 
 	irq_set_msi_desc(virq, desc);
 
-	msg.address_lo = msi_doorbell_addr;
-	msg.address_hi = 0;
-	msg.data = 0xf00 | (hwirq + 16);
+	armada_370_xp_compose_msi_msg(hwirq, &msg);
+	write_msi_msg(virq, &msg);
+	return 0;
+}
+
+static int armada_370_xp_setup_msi_irqs(struct msi_chip *chip,
+					struct pci_dev *pdev,
+					struct msi_desc *desc, int nvec)
+{
+	struct msi_msg msg;
+	int order = order_base_2(nvec);
+	int hwirq, virq, i;
 
+	if (nvec > PCI_MSI_DOORBELL_NR)
+		return PCI_MSI_DOORBELL_NR;
+
+	hwirq = armada_370_xp_alloc_msi(order);
+	if (hwirq < 0)
+		return hwirq;
+
+	virq = irq_alloc_descs(-1, 0, 1 << order, dev_to_node(&pdev->dev));
+	if (virq < 0)
+		goto err_free_msi;
+
+	if (irq_domain_associate_many(armada_370_xp_msi_domain, virq,
+				      hwirq, 1 << order))
+		goto err_free_descs;
+
+	for (i = 0; i < (1 << order); i++)
+		irq_set_msi_desc_off(virq, i, desc);
+
+	desc->msi_attrib.multiple = order;
+
+	armada_370_xp_compose_msi_msg(hwirq, &msg);
 	write_msi_msg(virq, &msg);
 	return 0;
+
+err_free_descs:
+	irq_free_descs(virq, 1 << order);
+err_free_msi:
+	mutex_lock(&msi_used_lock);
+	bitmap_release_region(msi_used, hwirq, order);
+	mutex_unlock(&msi_used_lock);
+	return -ENOSPC;
 }
 
 static void armada_370_xp_teardown_msi_irq(struct msi_chip *chip,
@@ -209,12 +272,46 @@ static void armada_370_xp_teardown_msi_irq(struct msi_chip *chip,
 	armada_370_xp_free_msi(d->hwirq);
 }
 
+#ifdef CONFIG_SMP
+static int armada_370_xp_msi_set_affinity(struct irq_data *d,
+					  const struct cpumask *mask_val,
+					  bool force)
+{
+	struct msi_desc *desc = irq_data_get_msi(d);
+	struct msi_msg msg;
+	unsigned int cpu;
+
+	/*
+	 * All vectors of a multiple message MSI block share one message,
+	 * so the block can only be moved as a whole, through its first
+	 * vector.
+	 */
+	if (!desc || (desc->msi_attrib.multiple && desc->irq != d->irq))
+		return -EINVAL;
+
+	cpu = cpumask_any_and(mask_val, &msi_cpus);
+	if (cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	__get_cached_msi_msg(desc, &msg);
+	msg.data = armada_370_xp_msi_data(irqd_to_hwirq(d), cpu);
+	__write_msi_msg(desc, &msg);
+
+	cpumask_copy(d->affinity, cpumask_of(cpu));
+
+	return IRQ_SET_MASK_OK_NOCOPY;
+}
+#endif
+
 static struct irq_chip armada_370_xp_msi_irq_chip = {
 	.name = "armada_370_xp_msi_irq",
 	.irq_enable = unmask_msi_irq,
 	.irq_disable = mask_msi_irq,
 	.irq_mask = mask_msi_irq,
 	.irq_unmask = unmask_msi_irq,
+#ifdef CONFIG_SMP
+	.irq_set_affinity = armada_370_xp_msi_set_affinity,
+#endif
 };
 
 static int armada_370_xp_msi_map(struct irq_domain *domain, unsigned int virq,
@@ -246,6 +343,7 @@ static int armada_370_xp_msi_init(struct device_node *node,
 		return -ENOMEM;
 
 	msi_chip->setup_irq = armada_370_xp_setup_msi_irq;
+	msi_chip->setup_irqs = armada_370_xp_setup_msi_irqs;
 	msi_chip->teardown_irq = armada_370_xp_teardown_msi_irq;
 	msi_chip->of_node = node;
 
@@ -271,17 +369,44 @@ static int armada_370_xp_msi_init(struct device_node *node,
 	writel(reg, per_cpu_int_base +
 	       ARMADA_370_XP_IN_DRBEL_MSK_OFFS);
 
-	/* Unmask IPI interrupt */
+	/* Unmask MSI interrupt */
 	writel(1, per_cpu_int_base + ARMADA_370_XP_INT_CLEAR_MASK_OFFS);
 
+	cpumask_set_cpu(smp_processor_id(), &msi_cpus);
+
 	return 0;
 }
+
+#ifdef CONFIG_SMP
+/*
+ * Let a secondary CPU receive MSIs as well. When the MPIC is cascaded
+ * (Armada 38x), the platform must also have enabled the parent per-CPU
+ * interrupt on that CPU.
+ */
+static void armada_370_xp_msi_cpu_init(void)
+{
+	u32 reg;
+
+	if (!armada_370_xp_msi_domain)
+		return;
+
+	reg = readl(per_cpu_int_base + ARMADA_370_XP_IN_DRBEL_MSK_OFFS)
+		| PCI_MSI_DOORBELL_MASK;
+	writel(reg, per_cpu_int_base + ARMADA_370_XP_IN_DRBEL_MSK_OFFS);
+
+	writel(1, per_cpu_int_base + ARMADA_370_XP_INT_CLEAR_MASK_OFFS);
+
+	cpumask_set_cpu(smp_processor_id(), &msi_cpus);
+}
+#endif
 #else
 static inline int armada_370_xp_msi_init(struct device_node *node,
 					 phys_addr_t main_int_phys_base)
 {
 	return 0;
 }
+
+static inline void armada_370_xp_msi_cpu_init(void) { }
 #endif
 
 #ifdef CONFIG_SMP
@@ -417,6 +542,17 @@ void armada_xp_mpic_smp_cpu_init(void)
 
 	/* Unmask IPI interrupt */
 	writel(0, per_cpu_int_base + ARMADA_370_XP_INT_CLEAR_MASK_OFFS);
+
+	armada_370_xp_msi_cpu_init();
+}
+
+/*
+ * On Armada 38x the MPIC is cascaded from the GIC and IPIs go through
+ * the GIC, so secondaries only need the MSI doorbells from the MPIC.
+ */
+void armada_38x_mpic_msi_cpu_init(void)
+{
+	armada_370_xp_msi_cpu_init();
 }
 #endif /* CONFIG_SMP */
 
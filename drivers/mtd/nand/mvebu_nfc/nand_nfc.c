@@ -25,6 +25,8 @@
 #include <linux/of_irq.h>
 #include <linux/irq.h>
 #include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 #include <asm/dma.h>
 #include "mvCommon.h"
 #include "mvOs.h"
@@ -33,11 +35,6 @@
 #error nand_nfc driver supports only DT configuration
 #endif
 
-#ifdef CONFIG_MV_INCLUDE_PDMA
-#include <asm/hardware/pxa-dma.h>
-#include "pdma/mvPdma.h"
-#include "pdma/mvPdmaRegs.h"
-#endif
 #include "nand_nfc.h"
 
 #define	DRIVER_NAME	"armada-nand"
@@ -54,6 +51,13 @@
 
 #define ARMADA_MAIN_PLL_FREQ	2000000000
 
+/* ONFI optional commands: read cache (31h/3Fh) */
+#define NFC_ONFI_OPT_CMD_READ_CACHE	(1 << 1)
+
+static bool cache_read = 1;
+module_param(cache_read, bool, 0644);
+MODULE_PARM_DESC(cache_read, "Pipeline multi-page reads with the NAND read cache commands when supported (default: 1)");
+
 char *cmd_text[] = {
 	"MV_NFC_CMD_READ_ID",
 	"MV_NFC_CMD_READ_STATUS",
@@ -122,7 +126,27 @@ struct orion_nfc_info {
 
 	unsigned char		*data_buff;
 	dma_addr_t		data_buff_phys;
-	size_t			data_buff_size;
+
+	/* page and spare buffers of the current transfer: data_buff or,
+	 * for read_page/write_page, the caller's buffers
+	 */
+	unsigned char		*io_data;
+	dma_addr_t		io_data_phys;
+	unsigned char		*io_oob;
+	dma_addr_t		io_oob_phys;
+	int			io_mapped;	/* io_* are the caller's */
+	int			read_pending;	/* READ0 not issued yet */
+
+	/* sequential reads through the NAND read cache */
+	int			seq_read;	/* flash has read cache */
+	struct mutex		seq_lock;	/* serializes seq_* users */
+	struct task_struct	*seq_task;	/* _read caller owning seq_last */
+	int			seq_last;	/* last page of that _read */
+	int			cache_next;	/* next page in cache, -1 if idle */
+	MV_NFC_CMD_TYPE		read_cmd;	/* first command of a page read */
+	int			(*nand_read)(struct mtd_info *mtd, loff_t from,
+					     size_t len, size_t *retlen,
+					     u_char *buf);
 
 	/* saved column/page_addr during CMD_SEQIN */
 	int			seqin_column;
@@ -130,7 +154,6 @@ struct orion_nfc_info {
 
 	/* relate to the command */
 	unsigned int		state;
-	unsigned int		use_dma;	/* use DMA ? */
 
 	/* flash information */
 	unsigned int		nfc_width;	/* Width of NFC 16/8 bits	*/
@@ -163,8 +186,6 @@ struct orion_nfc_info {
 	/* suspend / resume data */
 	MV_U32			nfcUnitData[128];
 	MV_U32			nfcDataLen;
-	MV_U32			pdmaUnitData[128];
-	MV_U32			pdmaDataLen;
 };
 
 /*
@@ -413,13 +434,13 @@ static struct orion_nfc_cmd_info orion_nfc_cmd_info_lkup[MV_NFC_CMD_COUNT] = {
 									MV_NFC_PIO_NONE}, /* MULTIPLANE_ERASE */
 	{(0),						(MV_NFC_STATUS_RDY),
 									MV_NFC_PIO_NONE}, /* RESET */
-	{(0),						(0),
+	{(NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK),	(0),
 									MV_NFC_PIO_READ}, /* CACHE_READ_SEQ */
 	{(0),						(0),
 									MV_NFC_PIO_READ}, /* CACHE_READ_RAND */
-	{(0),						(0),
-									MV_NFC_PIO_NONE}, /* EXIT_CACHE_READ */
-	{(0),						(0),
+	{(NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK),	(0),
+									MV_NFC_PIO_READ}, /* EXIT_CACHE_READ */
+	{(NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK),	(0),
 									MV_NFC_PIO_READ}, /* CACHE_READ_START */
 	{(NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK),	(0),
 									MV_NFC_PIO_READ}, /* READ_MONOLITHIC */
@@ -464,48 +485,6 @@ int orion_nfc_wait_for_completion_timeout(struct orion_nfc_info *info, int timeo
 
 }
 
-#ifdef CONFIG_MV_INCLUDE_PDMA
-static void orion_nfc_data_dma_irq(int irq, void *data)
-{
-	struct orion_nfc_info *info = data;
-	uint32_t dcsr, intr;
-	int channel = info->nfcCtrl.dataChanHndl.chanNumber;
-
-	intr = MV_REG_READ(PDMA_INTR_CAUSE_REG);
-	dcsr = MV_REG_READ(PDMA_CTRL_STATUS_REG(channel));
-	MV_REG_WRITE(PDMA_CTRL_STATUS_REG(channel), dcsr);
-
-	NFC_DPRINT((PRINT_LVL "orion_nfc_data_dma_irq(0x%x, 0x%x) - 1.\n", dcsr, intr));
-
-	if (info->chained_cmd) {
-		if (dcsr & DCSR_BUSERRINTR) {
-			info->retcode = ERR_DMABUSERR;
-			complete(&info->cmd_complete);
-		}
-		if ((info->state == STATE_DMA_READING) && (dcsr & DCSR_ENDINTR)) {
-			info->state = STATE_READY;
-			complete(&info->cmd_complete);
-		}
-		return;
-	}
-
-	if (dcsr & DCSR_BUSERRINTR) {
-		info->retcode = ERR_DMABUSERR;
-		complete(&info->cmd_complete);
-	}
-
-	if (info->state == STATE_DMA_WRITING) {
-		info->state = STATE_DMA_DONE;
-		mvNfcIntrSet(&info->nfcCtrl,  MV_NFC_STATUS_BBD | MV_NFC_STATUS_RDY , MV_TRUE);
-	} else {
-		info->state = STATE_READY;
-		complete(&info->cmd_complete);
-	}
-
-	return;
-}
-#endif
-
 static irqreturn_t orion_nfc_irq_pio(int irq, void *devid)
 {
 	struct orion_nfc_info *info = devid;
@@ -522,72 +501,6 @@ static irqreturn_t orion_nfc_irq_pio(int irq, void *devid)
 	return IRQ_HANDLED;
 }
 
-#ifdef CONFIG_MV_INCLUDE_PDMA
-static irqreturn_t orion_nfc_irq_dma(int irq, void *devid)
-{
-	struct orion_nfc_info *info = devid;
-	unsigned int status;
-
-	status = MV_REG_READ(NFC_STATUS_REG);
-
-	NFC_DPRINT((PRINT_LVL "orion_nfc_irq_dma(0x%x) - 1.\n", status));
-
-	if (!info->chained_cmd) {
-		if (status & (NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK)) {
-			if (status & NFC_SR_UNCERR_MASK)
-				info->retcode = ERR_DBERR;
-			mvNfcIntrSet(&info->nfcCtrl, NFC_SR_RDDREQ_MASK | NFC_SR_UNCERR_MASK, MV_FALSE);
-			if (info->use_dma) {
-				info->state = STATE_DMA_READING;
-				mvNfcReadWrite(&info->nfcCtrl, info->cmd,
-						(MV_U32 *)info->data_buff, info->data_buff_phys);
-			} else {
-				info->state = STATE_PIO_READING;
-				complete(&info->cmd_complete);
-			}
-		} else if (status & NFC_SR_WRDREQ_MASK) {
-			mvNfcIntrSet(&info->nfcCtrl, NFC_SR_WRDREQ_MASK, MV_FALSE);
-			if (info->use_dma) {
-				info->state = STATE_DMA_WRITING;
-				NFC_DPRINT((PRINT_LVL "Calling mvNfcReadWrite().\n"));
-				if (mvNfcReadWrite(&info->nfcCtrl, info->cmd,
-						   (MV_U32 *)info->data_buff,
-						   info->data_buff_phys)
-				    != MV_OK)
-					pr_err("mvNfcReadWrite() failed.\n");
-			} else {
-				info->state = STATE_PIO_WRITING;
-				complete(&info->cmd_complete);
-			}
-		} else if (status & (NFC_SR_BBD_MASK | MV_NFC_CS0_CMD_DONE_INT |
-				     NFC_SR_RDY0_MASK | MV_NFC_CS1_CMD_DONE_INT |
-				     NFC_SR_RDY1_MASK)) {
-			if (status & NFC_SR_BBD_MASK)
-				info->retcode = ERR_BBD;
-			mvNfcIntrSet(&info->nfcCtrl,  MV_NFC_STATUS_BBD |
-					MV_NFC_STATUS_CMDD | MV_NFC_STATUS_RDY,
-					MV_FALSE);
-			info->state = STATE_READY;
-			complete(&info->cmd_complete);
-		}
-	} else if (status & (NFC_SR_BBD_MASK | NFC_SR_RDY0_MASK |
-				NFC_SR_RDY1_MASK | NFC_SR_UNCERR_MASK)) {
-		if (status & (NFC_SR_BBD_MASK | NFC_SR_UNCERR_MASK))
-			info->retcode = ERR_DBERR;
-		mvNfcIntrSet(&info->nfcCtrl, MV_NFC_STATUS_BBD |
-				MV_NFC_STATUS_RDY | MV_NFC_STATUS_CMDD,
-				MV_FALSE);
-		if ((info->state != STATE_DMA_READING) ||
-		    (info->retcode == ERR_DBERR)) {
-			info->state = STATE_READY;
-			complete(&info->cmd_complete);
-		}
-	}
-	MV_REG_WRITE(NFC_STATUS_REG, status);
-	return IRQ_HANDLED;
-}
-#endif
-
 static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 		MV_NFC_MULTI_CMD *descInfo, u32 *numCmds)
 {
@@ -599,7 +512,7 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 		/* Main Chunks */
 		for (i = 0; i < CHUNK_CNT; i++) {
 			if (i == 0)
-				currDesc->cmd = MV_NFC_CMD_READ_MONOLITHIC;
+				currDesc->cmd = info->read_cmd;
 			else if ((i == (CHUNK_CNT-1)) && (LST_CHUNK_SZ == 0) && (LST_CHUNK_SPR == 0))
 				currDesc->cmd = MV_NFC_CMD_READ_LAST_NAKED;
 			else
@@ -607,21 +520,19 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 
 			currDesc->pageAddr = info->page_addr;
 			currDesc->pageCount = 1;
-			currDesc->virtAddr = (MV_U32 *)(info->data_buff + (i * CHUNK_SZ));
-			currDesc->physAddr = info->data_buff_phys + (i * CHUNK_SZ);
+			currDesc->virtAddr = (MV_U32 *)(info->io_data + (i * CHUNK_SZ));
+			currDesc->physAddr = info->io_data_phys + (i * CHUNK_SZ);
 			currDesc->length = (CHUNK_SZ + CHUNK_SPR);
 
 			if (CHUNK_SPR == 0)
 				currDesc->numSgBuffs = 1;
 			else {
 				currDesc->numSgBuffs = 2;
-				currDesc->sgBuffAddr[0] = (info->data_buff_phys + (i * CHUNK_SZ));
-				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->data_buff + (i * CHUNK_SZ));
+				currDesc->sgBuffAddr[0] = (info->io_data_phys + (i * CHUNK_SZ));
+				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->io_data + (i * CHUNK_SZ));
 				currDesc->sgBuffSize[0] = CHUNK_SZ;
-				currDesc->sgBuffAddr[1] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (i * CHUNK_SPR));
-				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (i * CHUNK_SPR));
+				currDesc->sgBuffAddr[1] = (info->io_oob_phys + (i * CHUNK_SPR));
+				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->io_oob + (i * CHUNK_SPR));
 				currDesc->sgBuffSize[1] = CHUNK_SPR;
 			}
 
@@ -636,26 +547,22 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 			currDesc->length = (LST_CHUNK_SPR + LST_CHUNK_SZ);
 
 			if ((LST_CHUNK_SZ == 0) && (LST_CHUNK_SPR != 0)) {		/* Spare only */
-				currDesc->virtAddr = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-									LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
-				currDesc->physAddr = info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-									LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT);
+				currDesc->virtAddr = (MV_U32 *)(info->io_oob + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->physAddr = info->io_oob_phys + (CHUNK_SPR * CHUNK_CNT);
 				currDesc->numSgBuffs = 1;
 				currDesc->length = LST_CHUNK_SPR;
 			} else if ((LST_CHUNK_SZ != 0) && (LST_CHUNK_SPR == 0)) {	/* Data only */
-				currDesc->virtAddr = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT));
-				currDesc->physAddr = info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT);
+				currDesc->virtAddr = (MV_U32 *)(info->io_data + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->physAddr = info->io_data_phys + (CHUNK_SZ * CHUNK_CNT);
 				currDesc->numSgBuffs = 1;
 				currDesc->length = LST_CHUNK_SZ;
 			} else {	/* Both spare and data */
 				currDesc->numSgBuffs = 2;
-				currDesc->sgBuffAddr[0] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT));
-				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->sgBuffAddr[0] = (info->io_data_phys + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->io_data + (CHUNK_SZ * CHUNK_CNT));
 				currDesc->sgBuffSize[0] = LST_CHUNK_SZ;
-				currDesc->sgBuffAddr[1] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
-				currDesc->sgBuffAddrVirt[1] =  (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->sgBuffAddr[1] = (info->io_oob_phys + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->sgBuffAddrVirt[1] =  (MV_U32 *)(info->io_oob + (CHUNK_SPR * CHUNK_CNT));
 				currDesc->sgBuffSize[1] = LST_CHUNK_SPR;
 			}
 			currDesc++;
@@ -676,21 +583,19 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 			currDesc->cmd = MV_NFC_CMD_WRITE_NAKED;
 			currDesc->pageAddr = info->page_addr;
 			currDesc->pageCount = 1;
-			currDesc->virtAddr = (MV_U32 *)(info->data_buff + (i * CHUNK_SZ));
-			currDesc->physAddr = info->data_buff_phys + (i * CHUNK_SZ);
+			currDesc->virtAddr = (MV_U32 *)(info->io_data + (i * CHUNK_SZ));
+			currDesc->physAddr = info->io_data_phys + (i * CHUNK_SZ);
 			currDesc->length = (CHUNK_SZ + CHUNK_SPR);
 
 			if (CHUNK_SPR == 0)
 				currDesc->numSgBuffs = 1;
 			else {
 				currDesc->numSgBuffs = 2;
-				currDesc->sgBuffAddr[0] = (info->data_buff_phys + (i * CHUNK_SZ));
-				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->data_buff + (i * CHUNK_SZ));
+				currDesc->sgBuffAddr[0] = (info->io_data_phys + (i * CHUNK_SZ));
+				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->io_data + (i * CHUNK_SZ));
 				currDesc->sgBuffSize[0] = CHUNK_SZ;
-				currDesc->sgBuffAddr[1] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (i * CHUNK_SPR));
-				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (i * CHUNK_SPR));
+				currDesc->sgBuffAddr[1] = (info->io_oob_phys + (i * CHUNK_SPR));
+				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->io_oob + (i * CHUNK_SPR));
 				currDesc->sgBuffSize[1] = CHUNK_SPR;
 			}
 
@@ -705,24 +610,20 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 			currDesc->length = (LST_CHUNK_SZ + LST_CHUNK_SPR);
 
 			if ((LST_CHUNK_SZ == 0) && (LST_CHUNK_SPR != 0)) {		/* Spare only */
-				currDesc->virtAddr = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-									LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
-				currDesc->physAddr = info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-									LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT);
+				currDesc->virtAddr = (MV_U32 *)(info->io_oob + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->physAddr = info->io_oob_phys + (CHUNK_SPR * CHUNK_CNT);
 				currDesc->numSgBuffs = 1;
 			} else if ((LST_CHUNK_SZ != 0) && (LST_CHUNK_SPR == 0)) {	/* Data only */
-				currDesc->virtAddr = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT));
-				currDesc->physAddr = info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT);
+				currDesc->virtAddr = (MV_U32 *)(info->io_data + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->physAddr = info->io_data_phys + (CHUNK_SZ * CHUNK_CNT);
 				currDesc->numSgBuffs = 1;
 			} else {	/* Both spare and data */
 				currDesc->numSgBuffs = 2;
-				currDesc->sgBuffAddr[0] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT));
-				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->sgBuffAddr[0] = (info->io_data_phys + (CHUNK_SZ * CHUNK_CNT));
+				currDesc->sgBuffAddrVirt[0] = (MV_U32 *)(info->io_data + (CHUNK_SZ * CHUNK_CNT));
 				currDesc->sgBuffSize[0] = LST_CHUNK_SZ;
-				currDesc->sgBuffAddr[1] = (info->data_buff_phys + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
-				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->data_buff + (CHUNK_SZ * CHUNK_CNT) +
-										LST_CHUNK_SZ + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->sgBuffAddr[1] = (info->io_oob_phys + (CHUNK_SPR * CHUNK_CNT));
+				currDesc->sgBuffAddrVirt[1] = (MV_U32 *)(info->io_oob + (CHUNK_SPR * CHUNK_CNT));
 				currDesc->sgBuffSize[1] = LST_CHUNK_SPR;
 			}
 			currDesc++;
@@ -740,8 +641,8 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 		descInfo[0].cmd = info->cmd;
 		descInfo[0].pageAddr = info->page_addr;
 		descInfo[0].pageCount = 1;
-		descInfo[0].virtAddr = (MV_U32 *)info->data_buff;
-		descInfo[0].physAddr = info->data_buff_phys;
+		descInfo[0].virtAddr = (MV_U32 *)info->io_data;
+		descInfo[0].physAddr = info->io_data_phys;
 		descInfo[0].numSgBuffs = 1;
 		descInfo[0].length = info->data_size;
 		*numCmds = 1;
@@ -750,75 +651,6 @@ static int orion_nfc_cmd_prepare(struct orion_nfc_info *info,
 	return 0;
 }
 
-#ifdef CONFIG_MV_INCLUDE_PDM
-static int orion_nfc_do_cmd_dma(struct orion_nfc_info *info,
-		uint32_t event)
-{
-	uint32_t ndcr;
-	int ret, timeout = CHIP_DELAY_TIMEOUT;
-	MV_STATUS status;
-	MV_U32	numCmds;
-
-	/* static allocation to avoid stack overflow*/
-	static MV_NFC_MULTI_CMD descInfo[NFC_MAX_NUM_OF_DESCR];
-
-	/* Clear all status bits. */
-	MV_REG_WRITE(NFC_STATUS_REG, NFC_SR_MASK);
-
-	mvNfcIntrSet(&info->nfcCtrl, event, MV_TRUE);
-
-	NFC_DPRINT((PRINT_LVL "\nAbout to issue dma cmd %d (cs %d) - 0x%x.\n",
-				info->cmd, info->nfcCtrl.currCs,
-				MV_REG_READ(NFC_CONTROL_REG)));
-	if ((info->cmd == MV_NFC_CMD_READ_MONOLITHIC) ||
-	    (info->cmd == MV_NFC_CMD_READ_ID) ||
-	    (info->cmd == MV_NFC_CMD_READ_STATUS))
-		info->state = STATE_DMA_READING;
-	else
-		info->state = STATE_CMD_HANDLE;
-	info->chained_cmd = 1;
-
-	orion_nfc_cmd_prepare(info, descInfo, &numCmds);
-
-	status = mvNfcCommandMultiple(&info->nfcCtrl, descInfo, numCmds);
-	if (status != MV_OK) {
-		pr_err("nfcCmdMultiple() failed for cmd %d (%d).\n",
-				info->cmd, status);
-		goto fail;
-	}
-
-	NFC_DPRINT((PRINT_LVL "After issue command %d - 0x%x.\n",
-				info->cmd, MV_REG_READ(NFC_STATUS_REG)));
-
-	ret = orion_nfc_wait_for_completion_timeout(info, timeout);
-	if (!ret) {
-		pr_err("Cmd %d execution timed out (0x%x) - cs %d.\n",
-				info->cmd, MV_REG_READ(NFC_STATUS_REG),
-				info->nfcCtrl.currCs);
-		info->retcode = ERR_CMD_TO;
-		goto fail_stop;
-	}
-
-	mvNfcIntrSet(&info->nfcCtrl, event | MV_NFC_STATUS_CMDD, MV_FALSE);
-
-	while (MV_PDMA_CHANNEL_STOPPED !=
-			mvPdmaChannelStateGet(&info->nfcCtrl.dataChanHndl)) {
-		if (info->retcode == ERR_NONE)
-			BUG();
-
-	}
-
-	return 0;
-
-fail_stop:
-	ndcr = MV_REG_READ(NFC_CONTROL_REG);
-	MV_REG_WRITE(NFC_CONTROL_REG, ndcr & ~NFC_CTRL_ND_RUN_MASK);
-	udelay(10);
-fail:
-	return -ETIMEDOUT;
-}
-#endif
-
 static int orion_nfc_error_check(struct orion_nfc_info *info)
 {
 	switch (info->cmd) {
@@ -847,7 +679,7 @@ static int orion_nfc_error_check(struct orion_nfc_info *info)
 	case MV_NFC_CMD_READ_LAST_NAKED:
 	case MV_NFC_CMD_READ_DISPATCH:
 		if (info->dscr & MV_NFC_UNCORR_ERR_INT) {
-			info->dscr = ERR_DBERR;
+			info->retcode = ERR_DBERR;
 			return 1;
 		}
 		break;
@@ -1025,6 +857,140 @@ static inline int is_buf_blank(uint8_t *buf, size_t len)
 	return 1;
 }
 
+static void orion_nfc_set_bounce(struct orion_nfc_info *info)
+{
+	size_t oob_offs = (CHUNK_SZ * CHUNK_CNT) + LST_CHUNK_SZ;
+
+	info->io_data = info->data_buff;
+	info->io_data_phys = info->data_buff_phys;
+	info->io_oob = info->data_buff + oob_offs;
+	info->io_oob_phys = info->data_buff_phys + oob_offs;
+}
+
+/*
+ * Point the next page transfer at the caller's page and spare buffers
+ * instead of data_buff. The FIFO is accessed a word at a time, so they
+ * have to be word aligned. Returns 0 if data_buff has to be used.
+ */
+static int orion_nfc_map_io(struct orion_nfc_info *info, struct mtd_info *mtd,
+			    uint8_t *data, uint8_t *oob)
+{
+	if (!IS_ALIGNED((unsigned long)data | (unsigned long)oob, 4) ||
+	    !IS_ALIGNED(mtd->oobsize, 4))
+		return 0;
+
+	info->io_data = data;
+	info->io_data_phys = 0;
+	info->io_oob = oob;
+	info->io_oob_phys = 0;
+	info->io_mapped = 1;
+	return 1;
+}
+
+static void orion_nfc_unmap_io(struct orion_nfc_info *info,
+			       struct mtd_info *mtd)
+{
+	if (!info->io_mapped)
+		return;
+
+	info->io_mapped = 0;
+	orion_nfc_set_bounce(info);
+}
+
+static void orion_nfc_check_dberr(struct orion_nfc_info *info,
+				  struct mtd_info *mtd, uint8_t *data)
+{
+	if (info->retcode != ERR_DBERR)
+		return;
+
+	/* for blank page (all 0xff), HW will calculate its ECC as
+	 * 0, which is different from the ECC information within
+	 * OOB, ignore such double bit errors
+	 */
+	if (is_buf_blank(data, mtd->writesize))
+		info->retcode = ERR_NONE;
+	else
+		pr_err("double bit error @ page %08x (%d)\n",
+		       info->page_addr, info->cmd);
+}
+
+/* Drop a cache read the caller did not follow up on */
+static void orion_nfc_cache_abort(struct orion_nfc_info *info)
+{
+	MV_NFC_CMD_TYPE cmd = info->cmd;
+	int retcode = info->retcode;
+
+	info->cache_next = -1;
+	info->cmd = MV_NFC_CMD_RESET;
+	orion_nfc_do_cmd_pio(info);
+	info->cmd = cmd;
+	info->retcode = retcode;
+}
+
+/*
+ * Last page the cache read may preload for @page: the end of the
+ * current multi-page _read, but never past the erase block.
+ */
+static int orion_nfc_seq_last(struct orion_nfc_info *info, int page)
+{
+	int block_last = page | (info->page_per_block - 1);
+
+	if (!info->seq_read || info->seq_task != current ||
+	    page > info->seq_last)
+		return -1;
+
+	return min(info->seq_last, block_last);
+}
+
+/*
+ * Read info->page_addr. Within a multi-page _read the first page is
+ * read with CACHE_READ_START, which already loads the next page into
+ * the array while this one streams out; following pages use
+ * CACHE_READ_SEQ and the last one EXIT_CACHE_READ.
+ */
+static void orion_nfc_read_page_cmd(struct orion_nfc_info *info)
+{
+	int page = info->page_addr;
+	int last = orion_nfc_seq_last(info, page);
+
+	if (info->cache_next >= 0 && info->cache_next != page)
+		orion_nfc_cache_abort(info);
+
+	if (info->cache_next == page)
+		info->read_cmd = (page >= last) ? MV_NFC_CMD_EXIT_CACHE_READ :
+						  MV_NFC_CMD_CACHE_READ_SEQ;
+	else if (last > page)
+		info->read_cmd = MV_NFC_CMD_CACHE_READ_START;
+	else
+		info->read_cmd = MV_NFC_CMD_READ_MONOLITHIC;
+
+	info->cache_next = (info->read_cmd == MV_NFC_CMD_CACHE_READ_START ||
+			    info->read_cmd == MV_NFC_CMD_CACHE_READ_SEQ) ?
+			   page + 1 : -1;
+
+	info->cmd = MV_NFC_CMD_READ_MONOLITHIC;
+	if (prepare_read_prog_cmd(info, info->column, info->page_addr) ||
+	    orion_nfc_do_cmd_pio(info)) {
+		if (info->cache_next >= 0)
+			orion_nfc_cache_abort(info);
+	}
+	info->read_cmd = MV_NFC_CMD_READ_MONOLITHIC;
+}
+
+/* Issue a READ0 the caller wants through data_buff after all */
+static void orion_nfc_flush_read(struct mtd_info *mtd)
+{
+	struct orion_nfc_info *info = (struct orion_nfc_info *)((struct nand_chip *)mtd->priv)->priv;
+
+	if (!info->read_pending)
+		return;
+
+	info->read_pending = 0;
+	memset(info->data_buff, 0xff, info->buf_count);
+	orion_nfc_read_page_cmd(info);
+	orion_nfc_check_dberr(info, mtd, info->data_buff);
+}
+
 static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 				int column, int page_addr)
 {
@@ -1034,6 +1000,12 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 	info->state = STATE_READY;
 	info->chained_cmd = 0;
 	info->retcode = ERR_NONE;
+	info->read_pending = 0;
+
+	/* anything but the next page of the run ends a cache read */
+	if (info->cache_next >= 0 &&
+	    (command != NAND_CMD_READ0 || page_addr != info->cache_next))
+		orion_nfc_cache_abort(info);
 
 	init_completion(&info->cmd_complete);
 
@@ -1047,14 +1019,7 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 		if (prepare_read_prog_cmd(info, column, page_addr))
 			break;
 
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_RDY | NFC_SR_UNCERR_MASK);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			orion_nfc_do_cmd_pio(info);
+		orion_nfc_do_cmd_pio(info);
 
 		/* We only are OOB, so if the data has error, does not matter */
 		if (info->retcode == ERR_DBERR)
@@ -1064,35 +1029,16 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 	case NAND_CMD_READ0:
 		info->buf_start = column;
 		info->buf_count = mtd->writesize + mtd->oobsize;
-		memset(info->data_buff, 0xff, info->buf_count);
-		info->cmd = MV_NFC_CMD_READ_MONOLITHIC;
 		info->column = column;
 		info->page_addr = page_addr;
 
-		if (prepare_read_prog_cmd(info, column, page_addr))
-			break;
-
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_RDY | NFC_SR_UNCERR_MASK);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			orion_nfc_do_cmd_pio(info);
-
-		if (info->retcode == ERR_DBERR) {
-			/* for blank page (all 0xff), HW will calculate its ECC as
-			 * 0, which is different from the ECC information within
-			 * OOB, ignore such double bit errors
-			 */
-			if (is_buf_blank(info->data_buff, mtd->writesize))
-				info->retcode = ERR_NONE;
-			else
-				printk(PRINT_LVL "%s: retCode == ERR_DBERR\n", __func__);
-		}
+		/* read_page transfers straight into the caller's buffer,
+		 * read_byte/read_buf issue the read into data_buff
+		 */
+		info->read_pending = 1;
 		break;
 	case NAND_CMD_SEQIN:
+		orion_nfc_unmap_io(info, mtd);
 		info->buf_start = column;
 		info->buf_count = mtd->writesize + mtd->oobsize;
 		memset(info->data_buff + mtd->writesize, 0xff, mtd->oobsize);
@@ -1111,14 +1057,8 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 			break;
 		}
 
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_RDY);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			orion_nfc_do_cmd_pio(info);
+		orion_nfc_do_cmd_pio(info);
+		orion_nfc_unmap_io(info, mtd);
 
 		break;
 	case NAND_CMD_ERASE1:
@@ -1126,14 +1066,7 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 		info->page_addr = page_addr;
 		info->cmd = MV_NFC_CMD_ERASE;
 
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_BBD | MV_NFC_STATUS_RDY);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			orion_nfc_do_cmd_pio(info);
+		orion_nfc_do_cmd_pio(info);
 
 		break;
 	case NAND_CMD_ERASE2:
@@ -1149,14 +1082,7 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 		info->cmd = (command == NAND_CMD_READID) ?
 			MV_NFC_CMD_READ_ID : MV_NFC_CMD_READ_STATUS;
 
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_RDY);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			orion_nfc_do_cmd_pio(info);
+		orion_nfc_do_cmd_pio(info);
 
 		break;
 	case NAND_CMD_RESET:
@@ -1167,14 +1093,7 @@ static void orion_nfc_cmdfunc(struct mtd_info *mtd, unsigned command,
 		info->page_addr = 0;
 		info->cmd = MV_NFC_CMD_RESET;
 
-		if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDM
-			ret = orion_nfc_do_cmd_dma(info, MV_NFC_STATUS_CMDD);
-#else
-			pr_err("DMA mode not supported!\n");
-#endif
-		else
-			ret = orion_nfc_do_cmd_pio(info);
+		ret = orion_nfc_do_cmd_pio(info);
 
 		if (ret == 0) {
 			int timeout = 2;
@@ -1213,6 +1132,7 @@ static uint8_t orion_nfc_read_byte(struct mtd_info *mtd)
 	struct orion_nfc_info *info = (struct orion_nfc_info *)((struct nand_chip *)mtd->priv)->priv;
 	char retval = 0xFF;
 
+	orion_nfc_flush_read(mtd);
 	if (info->buf_start < info->buf_count)
 		/* Has just send a new command? */
 		retval = info->data_buff[info->buf_start++];
@@ -1224,6 +1144,7 @@ static u16 orion_nfc_read_word(struct mtd_info *mtd)
 	struct orion_nfc_info *info = (struct orion_nfc_info *)((struct nand_chip *)mtd->priv)->priv;
 	u16 retval = 0xFFFF;
 
+	orion_nfc_flush_read(mtd);
 	if (!(info->buf_start & 0x01) && info->buf_start < info->buf_count) {
 		retval = *((u16 *)(info->data_buff+info->buf_start));
 		info->buf_start += 2;
@@ -1238,6 +1159,7 @@ static void orion_nfc_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
 	struct orion_nfc_info *info = (struct orion_nfc_info *)((struct nand_chip *)mtd->priv)->priv;
 	int real_len = min_t(size_t, len, info->buf_count - info->buf_start);
 
+	orion_nfc_flush_read(mtd);
 	memcpy(buf, info->data_buff + info->buf_start, real_len);
 	info->buf_start += real_len;
 }
@@ -1306,6 +1228,70 @@ static int orion_nfc_ecc_correct(struct mtd_info *mtd,
 	return 0;
 }
 
+static int orion_nfc_read_page(struct mtd_info *mtd, struct nand_chip *chip,
+		uint8_t *buf, int oob_required, int page)
+{
+	struct orion_nfc_info *info = (struct orion_nfc_info *)chip->priv;
+
+	if (info->read_pending &&
+	    orion_nfc_map_io(info, mtd, buf, chip->oob_poi)) {
+		info->read_pending = 0;
+		orion_nfc_read_page_cmd(info);
+		orion_nfc_unmap_io(info, mtd);
+		orion_nfc_check_dberr(info, mtd, buf);
+	} else {
+		chip->read_buf(mtd, buf, mtd->writesize);
+		chip->read_buf(mtd, chip->oob_poi, mtd->oobsize);
+	}
+
+	if (info->retcode != ERR_NONE) {
+		mtd->ecc_stats.failed++;
+		info->retcode = ERR_NONE;
+	}
+
+	return 0;
+}
+
+static int orion_nfc_write_page(struct mtd_info *mtd, struct nand_chip *chip,
+		const uint8_t *buf, int oob_required)
+{
+	struct orion_nfc_info *info = (struct orion_nfc_info *)chip->priv;
+
+	/* NAND_CMD_PAGEPROG programs from and releases the mapping */
+	if (orion_nfc_map_io(info, mtd, (uint8_t *)buf, chip->oob_poi))
+		return 0;
+
+	chip->write_buf(mtd, buf, mtd->writesize);
+	chip->write_buf(mtd, chip->oob_poi, mtd->oobsize);
+	return 0;
+}
+
+/*
+ * Multi-page reads within one chip hand their last page to the page
+ * reads below, which then keep the NAND read cache busy loading the
+ * next page while the current one is transferred.
+ */
+static int orion_nfc_read(struct mtd_info *mtd, loff_t from, size_t len,
+			  size_t *retlen, u_char *buf)
+{
+	struct nand_chip *chip = mtd->priv;
+	struct orion_nfc_info *info = (struct orion_nfc_info *)chip->priv;
+	int ret;
+
+	if (!info->seq_read || !cache_read || len <= mtd->writesize ||
+	    (from >> chip->chip_shift) != ((from + len - 1) >> chip->chip_shift))
+		return info->nand_read(mtd, from, len, retlen, buf);
+
+	mutex_lock(&info->seq_lock);
+	info->seq_last = ((from + len - 1) >> chip->page_shift) & chip->pagemask;
+	info->seq_task = current;
+	ret = info->nand_read(mtd, from, len, retlen, buf);
+	info->seq_task = NULL;
+	mutex_unlock(&info->seq_lock);
+
+	return ret;
+}
+
 static int orion_nfc_detect_flash(struct orion_nfc_info *info)
 {
 	MV_U32 my_page_size;
@@ -1357,29 +1343,9 @@ static int orion_nfc_init_buff(struct orion_nfc_info *info)
 {
 	struct platform_device *pdev = info->pdev;
 
-	if (info->use_dma == 0) {
-		info->data_buff = devm_kzalloc(&pdev->dev, MAX_BUFF_SIZE,
-					       GFP_KERNEL);
-		if (info->data_buff == NULL)
-			return -ENOMEM;
-		return 0;
-	}
-
-	info->data_buff = dma_alloc_coherent(&pdev->dev, MAX_BUFF_SIZE,
-				&info->data_buff_phys, GFP_KERNEL);
-	if (info->data_buff == NULL) {
-		dev_err(&pdev->dev, "failed to allocate dma buffer\n");
+	info->data_buff = devm_kzalloc(&pdev->dev, MAX_BUFF_SIZE, GFP_KERNEL);
+	if (info->data_buff == NULL)
 		return -ENOMEM;
-	}
-	memset(info->data_buff, 0xff, MAX_BUFF_SIZE);
-
-#ifdef CONFIG_MV_INCLUDE_PDM
-	if (pxa_request_dma_intr("nand-data", info->nfcCtrl.dataChanHndl.chanNumber,
-			orion_nfc_data_dma_irq, info) < 0) {
-		dev_err(&pdev->dev, "failed to request PDMA IRQ\n");
-		return -ENOMEM;
-	}
-#endif
 	return 0;
 }
 
@@ -1467,6 +1433,8 @@ static void orion_nfc_init_nand(struct nand_chip *nand, struct orion_nfc_info *i
 	nand->ecc.hwctl		= orion_nfc_ecc_hwctl;
 	nand->ecc.calculate	= orion_nfc_ecc_calculate;
 	nand->ecc.correct	= orion_nfc_ecc_correct;
+	nand->ecc.read_page	= orion_nfc_read_page;
+	nand->ecc.write_page	= orion_nfc_write_page;
 	nand->ecc.size		= pg_sz[info->page_size];
 	nand->ecc.layout	= ECC_LAYOUT;
 	/* Driver has to set ecc.strength when using hardware ECC */
@@ -1527,7 +1495,7 @@ static int orion_nfc_probe(struct platform_device *pdev)
 	struct resource *r;
 	int nr_parts = 0;
 	int ret, irq;
-	char *stat[2] = {"Disabled", "Enabled"};
+	u32 use_dma = 0;
 	char *ecc_stat[] = {"Hamming", "BCH 4bit", "BCH 8bit", "BCH 12bit", "BCH 16bit", "No"};
 	struct mtd_part_parser_data ppdata = {};
 	struct mtd_partition *parts = NULL;
@@ -1579,6 +1547,9 @@ static int orion_nfc_probe(struct platform_device *pdev)
 
 	/* Hookup pointers */
 	info->pdev = pdev;
+	info->cache_next = -1;
+	info->read_cmd = MV_NFC_CMD_READ_MONOLITHIC;
+	mutex_init(&info->seq_lock);
 	nand->priv = info;
 	mtd->priv = nand;
 	mtd->name = DRIVER_NAME;
@@ -1586,12 +1557,16 @@ static int orion_nfc_probe(struct platform_device *pdev)
 
 	/* Parse DT tree and acquire all necessary data */
 	ret = 0;
-	ret |= of_property_read_u32(np, "nfc,nfc-dma", &info->use_dma);
+	ret |= of_property_read_u32(np, "nfc,nfc-dma", &use_dma);
 	ret |= of_property_read_u32(np, "nfc,nfc-width", &info->nfc_width);
 	ret |= of_property_read_u32(np, "nfc,ecc-type", &info->ecc_type);
 	ret |= of_property_read_u32(np, "nfc,num-cs", &info->num_cs);
 	ret |= of_property_read_u32(np, "reg", &mv_nand_offset);
 
+	/* there is no PDMA backend for the NFC in this tree */
+	if (use_dma)
+		dev_warn(&pdev->dev, "DMA is not supported, using PIO\n");
+
 	/* Determine the NAND Flash Controller mode for later usage */
 	info->nfc_mode = of_get_property(np, "nfc,nfc-mode", NULL);
 	if (!info->nfc_mode || (strncmp(info->nfc_mode, "normal", 6) &&
@@ -1618,8 +1593,8 @@ static int orion_nfc_probe(struct platform_device *pdev)
 	/* Save acquired IRQ mapping */
 	info->irq = irq;
 
-	dev_info(&pdev->dev, "Initialize HAL based NFC in %dbit mode with DMA %s using %s ECC\n",
-			  info->nfc_width, stat[info->use_dma], ecc_stat[info->ecc_type]);
+	dev_info(&pdev->dev, "Initialize HAL based NFC in %dbit mode using %s ECC\n",
+			  info->nfc_width, ecc_stat[info->ecc_type]);
 
 	r = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	if (r == NULL) {
@@ -1646,15 +1621,9 @@ static int orion_nfc_probe(struct platform_device *pdev)
 
 	info->mmio_phys_base = r->start;
 
-#ifdef CONFIG_MV_INCLUDE_PDMA
-	if (mvPdmaHalInit(MV_PDMA_MAX_CHANNELS_NUM) != MV_OK) {
-		dev_err(&pdev->dev, "mvPdmaHalInit() failed.\n");
-		goto fail_dispose_irq;
-	}
-#endif
 	/* Initialize NFC HAL */
 	mv_nand_base = (MV_U32)info->mmio_base;
-	nfcInfo.ioMode = (info->use_dma ? MV_NFC_PDMA_ACCESS : MV_NFC_PIO_ACCESS);
+	nfcInfo.ioMode = MV_NFC_PIO_ACCESS;
 	nfcInfo.eccMode = info->ecc_type;
 
 	if (strncmp(info->nfc_mode, "normal", 6) == 0)
@@ -1665,10 +1634,6 @@ static int orion_nfc_probe(struct platform_device *pdev)
 	nfcInfo.readyBypass = MV_FALSE;
 	nfcInfo.osHandle = NULL;
 	nfcInfo.regsPhysAddr = mv_nand_base - mv_nand_offset;
-#ifdef CONFIG_MV_INCLUDE_PDMA
-	nfcInfo.dataPdmaIntMask = MV_PDMA_END_OF_RX_INTR_EN | MV_PDMA_END_INTR_EN;
-	nfcInfo.cmdPdmaIntMask = 0x0;
-#endif
 
 	status = mvSysNfcInit(&nfcInfo, &info->nfcCtrl);
 	if (status != MV_OK) {
@@ -1689,20 +1654,12 @@ static int orion_nfc_probe(struct platform_device *pdev)
 
 	/* Clear all old events on the status register */
 	MV_REG_WRITE(NFC_STATUS_REG, MV_REG_READ(NFC_STATUS_REG));
-	if (info->use_dma)
-#ifdef CONFIG_MV_INCLUDE_PDMA
-		ret = request_irq(irq, orion_nfc_irq_dma, IRQF_DISABLED,
-				pdev->name, info);
-#else
-		pr_err("DMA mode not supported!\n");
-#endif
-	else
-		ret = request_irq(irq, orion_nfc_irq_pio, IRQF_DISABLED,
-				pdev->name, info);
+	ret = request_irq(irq, orion_nfc_irq_pio, IRQF_DISABLED,
+			pdev->name, info);
 
 	if (ret < 0) {
 		dev_err(&pdev->dev, "failed to request IRQ\n");
-		goto fail_free_buf;
+		goto fail_dispose_irq;
 	}
 
 	ret = orion_nfc_detect_flash(info);
@@ -1713,6 +1670,7 @@ static int orion_nfc_probe(struct platform_device *pdev)
 	}
 
 	orion_nfc_init_nand(nand, info);
+	orion_nfc_set_bounce(info);
 
 	if (nand->ecc.layout == NULL) {
 		dev_err(&pdev->dev, "Undefined ECC layout for selected nand device\n");
@@ -1728,6 +1686,15 @@ static int orion_nfc_probe(struct platform_device *pdev)
 		goto fail_free_irq;
 	}
 
+	/* Use the read cache when the flash advertises it */
+	info->page_per_block = mtd->erasesize >> nand->page_shift;
+	if (nand->onfi_version &&
+	    (le16_to_cpu(nand->onfi_params.opt_cmd) & NFC_ONFI_OPT_CMD_READ_CACHE)) {
+		info->seq_read = 1;
+		info->nand_read = mtd->_read;
+		mtd->_read = orion_nfc_read;
+	}
+
 	ppdata.of_node = pdev->dev.of_node;
 	ret = mtd_device_parse_register(mtd, NULL, &ppdata, parts,
 					nr_parts);
@@ -1740,10 +1707,6 @@ static int orion_nfc_probe(struct platform_device *pdev)
 
 fail_free_irq:
 	free_irq(irq, info);
-fail_free_buf:
-	if (info->use_dma)
-		dma_free_coherent(&pdev->dev, info->data_buff_size,
-			info->data_buff, info->data_buff_phys);
 fail_dispose_irq:
 	irq_dispose_mapping(info->irq);
 fail_put_clk:
@@ -1770,10 +1733,6 @@ static int orion_nfc_remove(struct platform_device *pdev)
 	free_irq(info->irq, info);
 	irq_dispose_mapping(info->irq);
 
-	if (info->use_dma)
-		dma_free_writecombine(&pdev->dev, info->data_buff_size,
-				info->data_buff, info->data_buff_phys);
-
 	if (mtd)
 		mtd_device_unregister(mtd);
 
@@ -1791,12 +1750,6 @@ static int orion_nfc_suspend(struct platform_device *pdev, pm_message_t state)
 		return -EAGAIN;
 	}
 
-#ifdef CONFIG_MV_INCLUDE_PDMA
-	/* Store PDMA registers.	*/
-	info->pdmaDataLen = 128;
-	mvPdmaUnitStateStore(info->pdmaUnitData, &info->pdmaDataLen);
-#endif
-
 	/* Store NFC registers.	*/
 	info->nfcDataLen = 128;
 	mvNfcUnitStateStore(info->nfcUnitData, &info->nfcDataLen);
@@ -1814,11 +1767,6 @@ static int orion_nfc_resume(struct platform_device *pdev)
 	MV_U32	i;
 #if 0
 	clk_enable(info->clk);
-#endif
-#ifdef CONFIG_MV_INCLUDE_PDMA
-	/* restore PDMA registers */
-	for (i = 0; i < info->pdmaDataLen; i += 2)
-		MV_REG_WRITE(info->pdmaUnitData[i], info->pdmaUnitData[i+1]);
 #endif
 	/* Clear all NAND interrupts */
 	MV_REG_WRITE(NFC_STATUS_REG, MV_REG_READ(NFC_STATUS_REG));
@@ -87,10 +87,21 @@
 #include <linux/crc32.h>
 #include <linux/math64.h>
 #include <linux/random.h>
+#include <linux/module.h>
+#include <linux/workqueue.h>
+#include <linux/completion.h>
 #include "ubi.h"
 
 static int self_check_ai(struct ubi_device *ubi, struct ubi_attach_info *ai);
 
+/* How many PEBs ahead of the one being processed have their headers read */
+#define SCAN_READ_AHEAD 64
+
+/* Number of threads reading UBI headers when attaching by scanning */
+static int scan_threads = 4;
+module_param(scan_threads, int, 0644);
+MODULE_PARM_DESC(scan_threads, "Number of threads reading UBI headers when attaching by scanning, 0 to read them sequentially (default 4).");
+
 /* Temporary variables used during scanning */
 static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
@@ -801,28 +812,78 @@ out_unlock:
 }
 
 /**
- * scan_peb - scan and process UBI headers of a PEB.
+ * struct peb_hdrs - UBI headers of a PEB, read ahead of their processing.
+ * @pnum: the physical eraseblock number
+ * @bad: what 'ubi_io_is_bad()' returned
+ * @ec_err: what 'ubi_io_read_ec_hdr()' returned
+ * @vid_err: what 'ubi_io_read_vid_hdr()' returned
+ * @ech: the EC header buffer
+ * @vidh: the VID header buffer
+ * @ubi: UBI device description object, for @work
+ * @work: reads the headers in the scanning workqueue
+ * @done: completed once the headers have been read
+ */
+struct peb_hdrs {
+	int pnum;
+	int bad;
+	int ec_err;
+	int vid_err;
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_hdr *vidh;
+	struct ubi_device *ubi;
+	struct work_struct work;
+	struct completion done;
+};
+
+/**
+ * read_peb_hdrs - read UBI headers of a PEB.
+ * @ubi: UBI device description object
+ * @h: where to store the headers, @h->pnum is the PEB to read
+ *
+ * This function only does the I/O part of the scanning of a PEB and stores
+ * the results in @h for 'process_peb()'. It does not touch the attaching
+ * information, so it may run for several PEBs in parallel.
+ */
+static void read_peb_hdrs(struct ubi_device *ubi, struct peb_hdrs *h)
+{
+	dbg_bld("read headers of PEB %d", h->pnum);
+
+	h->ec_err = h->vid_err = 0;
+	h->bad = ubi_io_is_bad(ubi, h->pnum);
+	if (h->bad)
+		return;
+
+	h->ec_err = ubi_io_read_ec_hdr(ubi, h->pnum, h->ech, 0);
+	if (h->ec_err < 0 || h->ec_err == UBI_IO_FF ||
+	    h->ec_err == UBI_IO_FF_BITFLIPS)
+		return;
+
+	h->vid_err = ubi_io_read_vid_hdr(ubi, h->pnum, h->vidh, 0);
+}
+
+/**
+ * process_peb - process UBI headers of a PEB.
  * @ubi: UBI device description object
  * @ai: attaching information
- * @pnum: the physical eraseblock number
+ * @h: the headers of the PEB, as read by 'read_peb_hdrs()'
  * @vid: The volume ID of the found volume will be stored in this pointer
  * @sqnum: The sqnum of the found volume will be stored in this pointer
  *
- * This function reads UBI headers of PEB @pnum, checks them, and adds
- * information about this PEB to the corresponding list or RB-tree in the
- * "attaching info" structure. Returns zero if the physical eraseblock was
- * successfully handled and a negative error code in case of failure.
+ * This function checks the UBI headers of a PEB, and adds information about
+ * this PEB to the corresponding list or RB-tree in the "attaching info"
+ * structure. Returns zero if the physical eraseblock was successfully handled
+ * and a negative error code in case of failure.
  */
-static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
-		    int pnum, int *vid, unsigned long long *sqnum)
+static int process_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
+		       struct peb_hdrs *h, int *vid, unsigned long long *sqnum)
 {
 	long long uninitialized_var(ec);
-	int err, bitflips = 0, vol_id = -1, ec_err = 0;
+	int err, bitflips = 0, vol_id = -1, ec_err = 0, pnum = h->pnum;
 
-	dbg_bld("scan PEB %d", pnum);
+	dbg_bld("process PEB %d", pnum);
 
 	/* Skip bad physical eraseblocks */
-	err = ubi_io_is_bad(ubi, pnum);
+	err = h->bad;
 	if (err < 0)
 		return err;
 	else if (err) {
@@ -830,7 +891,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
-	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+	err = h->ec_err;
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -867,13 +928,13 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		int image_seq;
 
 		/* Make sure UBI version is OK */
-		if (ech->version != UBI_VERSION) {
+		if (h->ech->version != UBI_VERSION) {
 			ubi_err("this UBI version is %d, image version is %d",
-				UBI_VERSION, (int)ech->version);
+				UBI_VERSION, (int)h->ech->version);
 			return -EINVAL;
 		}
 
-		ec = be64_to_cpu(ech->ec);
+		ec = be64_to_cpu(h->ech->ec);
 		if (ec > UBI_MAX_ERASECOUNTER) {
 			/*
 			 * Erase counter overflow. The EC headers have 64 bits
@@ -884,7 +945,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 			 */
 			ubi_err("erase counter overflow, max is %d",
 				UBI_MAX_ERASECOUNTER);
-			ubi_dump_ec_hdr(ech);
+			ubi_dump_ec_hdr(h->ech);
 			return -EINVAL;
 		}
 
@@ -899,21 +960,21 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		 * sequence number, while other PEBs have non-zero sequence
 		 * number.
 		 */
-		image_seq = be32_to_cpu(ech->image_seq);
+		image_seq = be32_to_cpu(h->ech->image_seq);
 		if (!ubi->image_seq && image_seq)
 			ubi->image_seq = image_seq;
 		if (ubi->image_seq && image_seq &&
 		    ubi->image_seq != image_seq) {
 			ubi_err("bad image sequence number %d in PEB %d, expected %d",
 				image_seq, pnum, ubi->image_seq);
-			ubi_dump_ec_hdr(ech);
+			ubi_dump_ec_hdr(h->ech);
 			return -EINVAL;
 		}
 	}
 
 	/* OK, we've done with the EC header, let's look at the VID header */
 
-	err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+	err = h->vid_err;
 	if (err < 0)
 		return err;
 	switch (err) {
@@ -951,7 +1012,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 			 * The EC was OK, but the VID header is corrupted. We
 			 * have to check what is in the data area.
 			 */
-			err = check_corruption(ubi, vidh, pnum);
+			err = check_corruption(ubi, h->vidh, pnum);
 
 		if (err < 0)
 			return err;
@@ -987,16 +1048,16 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return -EINVAL;
 	}
 
-	vol_id = be32_to_cpu(vidh->vol_id);
+	vol_id = be32_to_cpu(h->vidh->vol_id);
 	if (vid)
 		*vid = vol_id;
 	if (sqnum)
-		*sqnum = be64_to_cpu(vidh->sqnum);
+		*sqnum = be64_to_cpu(h->vidh->sqnum);
 	if (vol_id > UBI_MAX_VOLUMES && vol_id != UBI_LAYOUT_VOLUME_ID) {
-		int lnum = be32_to_cpu(vidh->lnum);
+		int lnum = be32_to_cpu(h->vidh->lnum);
 
 		/* Unsupported internal volume */
-		switch (vidh->compat) {
+		switch (h->vidh->compat) {
 		case UBI_COMPAT_DELETE:
 			if (vol_id != UBI_FM_SB_VOLUME_ID
 			    && vol_id != UBI_FM_DATA_VOLUME_ID) {
@@ -1034,7 +1095,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (ec_err)
 		ubi_warn("valid VID header but corrupted EC header at PEB %d",
 			 pnum);
-	err = ubi_add_to_av(ubi, ai, pnum, ec, vidh, bitflips);
+	err = ubi_add_to_av(ubi, ai, pnum, ec, h->vidh, bitflips);
 	if (err)
 		return err;
 
@@ -1051,6 +1112,118 @@ adjust_mean_ec:
 	return 0;
 }
 
+/**
+ * scan_peb - scan and process UBI headers of a PEB.
+ * @ubi: UBI device description object
+ * @ai: attaching information
+ * @pnum: the physical eraseblock number
+ * @vid: The volume ID of the found volume will be stored in this pointer
+ * @sqnum: The sqnum of the found volume will be stored in this pointer
+ *
+ * This function reads UBI headers of PEB @pnum, checks them, and adds
+ * information about this PEB to the corresponding list or RB-tree in the
+ * "attaching info" structure. Returns zero if the physical eraseblock was
+ * successfully handled and a negative error code in case of failure.
+ */
+static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
+		    int pnum, int *vid, unsigned long long *sqnum)
+{
+	struct peb_hdrs h = { .pnum = pnum, .ech = ech, .vidh = vidh };
+
+	read_peb_hdrs(ubi, &h);
+	return process_peb(ubi, ai, &h, vid, sqnum);
+}
+
+static void read_peb_hdrs_work(struct work_struct *work)
+{
+	struct peb_hdrs *h = container_of(work, struct peb_hdrs, work);
+
+	read_peb_hdrs(h->ubi, h);
+	complete(&h->done);
+}
+
+/**
+ * scan_pebs_ahead - scan PEBs, reading their headers ahead.
+ * @ubi: UBI device description object
+ * @ai: attach info object
+ * @start: start scanning at this PEB
+ *
+ * The headers of the next %SCAN_READ_AHEAD PEBs are read by a workqueue with
+ * @scan_threads workers, while this function processes the PEBs in order as
+ * their headers arrive. This way processing overlaps with flash I/O, and MTD
+ * drivers which can have several reads in flight (several chips, DMA) are
+ * kept busy. The result is the same as calling 'scan_peb()' for each PEB.
+ * Returns zero in case of success and a negative error code in case of
+ * failure.
+ */
+static int scan_pebs_ahead(struct ubi_device *ubi, struct ubi_attach_info *ai,
+			   int start)
+{
+	int i, pnum, err = 0, count = ubi->peb_count - start;
+	struct workqueue_struct *wq;
+	struct peb_hdrs *hdrs;
+
+	if (count <= 0)
+		return 0;
+	count = min(count, SCAN_READ_AHEAD);
+
+	hdrs = kcalloc(count, sizeof(struct peb_hdrs), GFP_KERNEL);
+	if (!hdrs)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		hdrs[i].ubi = ubi;
+		hdrs[i].ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+		hdrs[i].vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+		if (!hdrs[i].ech || !hdrs[i].vidh) {
+			err = -ENOMEM;
+			goto out_free;
+		}
+		INIT_WORK(&hdrs[i].work, read_peb_hdrs_work);
+		init_completion(&hdrs[i].done);
+	}
+
+	wq = alloc_workqueue("ubi_scan", WQ_UNBOUND, scan_threads);
+	if (!wq) {
+		err = -ENOMEM;
+		goto out_free;
+	}
+
+	for (i = 0; i < count; i++) {
+		hdrs[i].pnum = start + i;
+		queue_work(wq, &hdrs[i].work);
+	}
+
+	for (pnum = start; pnum < ubi->peb_count; pnum++) {
+		struct peb_hdrs *h = &hdrs[(pnum - start) % count];
+
+		wait_for_completion(&h->done);
+
+		dbg_gen("process PEB %d", pnum);
+		err = process_peb(ubi, ai, h, NULL, NULL);
+		if (err < 0)
+			break;
+
+		if (pnum + count < ubi->peb_count) {
+			h->pnum = pnum + count;
+			INIT_COMPLETION(h->done);
+			queue_work(wq, &h->work);
+		}
+		cond_resched();
+	}
+
+	/* This also waits for the reads still in flight if we failed */
+	destroy_workqueue(wq);
+
+out_free:
+	for (i = 0; i < count; i++) {
+		ubi_free_vid_hdr(ubi, hdrs[i].vidh);
+		kfree(hdrs[i].ech);
+	}
+	kfree(hdrs);
+	return err;
+}
+
 /**
  * late_analysis - analyze the overall situation with PEB.
  * @ubi: UBI device description object
@@ -1240,13 +1413,19 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = start; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
-
-		dbg_gen("process PEB %d", pnum);
-		err = scan_peb(ubi, ai, pnum, NULL, NULL);
+	if (scan_threads > 0) {
+		err = scan_pebs_ahead(ubi, ai, start);
 		if (err < 0)
 			goto out_vidh;
+	} else {
+		for (pnum = start; pnum < ubi->peb_count; pnum++) {
+			cond_resched();
+
+			dbg_gen("process PEB %d", pnum);
+			err = scan_peb(ubi, ai, pnum, NULL, NULL);
+			if (err < 0)
+				goto out_vidh;
+		}
 	}
 
 	ubi_msg("scanning is finished");
@@ -1395,6 +1574,7 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	ktime_t start = ktime_get();
 
 	ai = alloc_ai("ubi_aeb_slab_cache");
 	if (!ai)
@@ -1469,6 +1649,10 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	}
 #endif
 
+	ubi_msg("attached %d PEBs by %s in %lld ms", ubi->peb_count,
+		ubi->fm ? "fastmap" : "scanning",
+		ktime_to_ms(ktime_sub(ktime_get(), start)));
+
 	destroy_ai(ai);
 	return 0;
 
@@ -80,6 +80,8 @@ static struct mtd_dev_param __initdata mtd_dev_param[UBI_MAX_DEVICES];
 /* UBI module parameter to enable fastmap automatically on non-fastmap images */
 static bool fm_autoconvert;
 #endif
+/* UBI module parameter for the number of background threads per device */
+static int bgt_threads = 2;
 /* Root UBI "class" object (corresponds to '/<sysfs>/class/ubi/') */
 struct class *ubi_class;
 
@@ -1005,12 +1007,22 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	if (err)
 		goto out_uif;
 
-	ubi->bgt_thread = kthread_create(ubi_thread, ubi, ubi->bgt_name);
-	if (IS_ERR(ubi->bgt_thread)) {
-		err = PTR_ERR(ubi->bgt_thread);
-		ubi_err("cannot spawn \"%s\", error %d", ubi->bgt_name,
-			err);
-		goto out_debugfs;
+	ubi->bgt_count = clamp(bgt_threads, 1, UBI_MAX_BGT_THREADS);
+	for (i = 0; i < ubi->bgt_count; i++) {
+		struct task_struct *t;
+
+		if (i == 0)
+			t = kthread_create(ubi_thread, ubi, "%s", ubi->bgt_name);
+		else
+			t = kthread_create(ubi_thread, ubi, "%s/%d",
+					   ubi->bgt_name, i);
+		if (IS_ERR(t)) {
+			err = PTR_ERR(t);
+			ubi_err("cannot spawn \"%s\", error %d", ubi->bgt_name,
+				err);
+			goto out_bgt;
+		}
+		ubi->bgt_thread[i] = t;
 	}
 
 	ubi_msg("attached mtd%d (name \"%s\", size %llu MiB) to ubi%d",
@@ -1031,6 +1043,7 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 		ubi->image_seq);
 	ubi_msg("available PEBs: %d, total reserved PEBs: %d, PEBs reserved for bad PEB handling: %d",
 		ubi->avail_pebs, ubi->rsvd_pebs, ubi->beb_rsvd_pebs);
+	ubi_msg("background threads: %d", ubi->bgt_count);
 
 	/*
 	 * The below lock makes sure we do not race with 'ubi_thread()' which
@@ -1038,13 +1051,19 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	 */
 	spin_lock(&ubi->wl_lock);
 	ubi->thread_enabled = 1;
-	wake_up_process(ubi->bgt_thread);
+	for (i = 0; i < ubi->bgt_count; i++)
+		wake_up_process(ubi->bgt_thread[i]);
 	spin_unlock(&ubi->wl_lock);
 
 	ubi_devices[ubi_num] = ubi;
 	ubi_notify_all(ubi, UBI_VOLUME_ADDED, NULL);
 	return ubi_num;
 
+out_bgt:
+	while (i--) {
+		kthread_stop(ubi->bgt_thread[i]);
+		ubi->bgt_thread[i] = NULL;
+	}
 out_debugfs:
 	ubi_debugfs_exit_dev(ubi);
 out_uif:
@@ -1081,6 +1100,7 @@ out_free:
 int ubi_detach_mtd_dev(int ubi_num, int anyway)
 {
 	struct ubi_device *ubi;
+	int i;
 
 	if (ubi_num < 0 || ubi_num >= UBI_MAX_DEVICES)
 		return -EINVAL;
@@ -1116,8 +1136,9 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	 * Before freeing anything, we have to stop the background thread to
 	 * prevent it from doing anything on this device while we are freeing.
 	 */
-	if (ubi->bgt_thread)
-		kthread_stop(ubi->bgt_thread);
+	for (i = 0; i < ubi->bgt_count; i++)
+		if (ubi->bgt_thread[i])
+			kthread_stop(ubi->bgt_thread[i]);
 
 	/*
 	 * Get a reference to the device in order to prevent 'dev_release()'
@@ -1459,6 +1480,9 @@ MODULE_PARM_DESC(mtd, "MTD devices to attach. Parameter format: mtd=<name|num|pa
 module_param(fm_autoconvert, bool, 0644);
 MODULE_PARM_DESC(fm_autoconvert, "Set this parameter to enable fastmap automatically on images without a fastmap.");
 #endif
+module_param(bgt_threads, int, 0644);
+MODULE_PARM_DESC(bgt_threads, "Number of background threads doing erasures and wear-leveling per UBI device, 1-"
+			      __stringify(UBI_MAX_BGT_THREADS) " (default 2). Applies to devices attached later.");
 MODULE_VERSION(__stringify(UBI_VERSION));
 MODULE_DESCRIPTION("UBI - Unsorted Block Images");
 MODULE_AUTHOR("Artem Bityutskiy");
@@ -22,6 +22,8 @@
 #include <linux/debugfs.h>
 #include <linux/uaccess.h>
 #include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 
 /**
@@ -359,6 +361,58 @@ static const struct file_operations dfs_fops = {
 	.owner  = THIS_MODULE,
 };
 
+/* Show the statistics of the WL sub-system work queues */
+static int dfs_wl_stats_show(struct seq_file *m, void *v)
+{
+	unsigned long ubi_num = (unsigned long)m->private;
+	struct ubi_wl_stats st;
+	struct ubi_device *ubi;
+	int works, erase_works;
+
+	ubi = ubi_get_device(ubi_num);
+	if (!ubi)
+		return -ENODEV;
+
+	spin_lock(&ubi->wl_lock);
+	st = ubi->wl_stats;
+	works = ubi->works_count;
+	erase_works = ubi->erase_works_count;
+	spin_unlock(&ubi->wl_lock);
+
+	seq_printf(m, "background threads: %d\n", ubi->bgt_count);
+	seq_printf(m, "pending works:      %d (max %d)\n", works, st.depth_max);
+	seq_printf(m, "pending erasures:   %d (max %d)\n", erase_works,
+		   st.erase_depth_max);
+	seq_printf(m, "erasures:    %lu, queued avg %llu us, max %llu us\n",
+		   st.erase_works, st.erase_works ?
+		   div64_u64(st.erase_wait_ns, st.erase_works * 1000) : 0,
+		   div64_u64(st.erase_wait_max_ns, 1000));
+	seq_printf(m, "wl/scrub:    %lu, queued avg %llu us, max %llu us\n",
+		   st.other_works, st.other_works ?
+		   div64_u64(st.other_wait_ns, st.other_works * 1000) : 0,
+		   div64_u64(st.other_wait_max_ns, 1000));
+	seq_printf(m, "free PEB waits: %lu, avg %llu us, max %llu us\n",
+		   st.free_waits, st.free_waits ?
+		   div64_u64(st.free_wait_ns, st.free_waits * 1000) : 0,
+		   div64_u64(st.free_wait_max_ns, 1000));
+
+	ubi_put_device(ubi);
+	return 0;
+}
+
+static int dfs_wl_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dfs_wl_stats_show, inode->i_private);
+}
+
+static const struct file_operations dfs_wl_stats_fops = {
+	.open    = dfs_wl_stats_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+	.owner   = THIS_MODULE,
+};
+
 /**
  * ubi_debugfs_init_dev - initialize debugfs for an UBI device.
  * @ubi: UBI device description object
@@ -427,6 +481,12 @@ int ubi_debugfs_init_dev(struct ubi_device *ubi)
 		goto out_remove;
 	d->dfs_emulate_io_failures = dent;
 
+	fname = "wl_stats";
+	dent = debugfs_create_file(fname, S_IRUSR, d->dfs_dir, (void *)ubi_num,
+				   &dfs_wl_stats_fops);
+	if (IS_ERR_OR_NULL(dent))
+		goto out_remove;
+
 	return 0;
 
 out_remove:
@@ -1176,7 +1176,7 @@ static int ubi_write_fastmap(struct ubi_device *ubi,
 	fmh->scrub_peb_count = cpu_to_be32(scrub_peb_count);
 
 
-	list_for_each_entry(ubi_wrk, &ubi->works, list) {
+	list_for_each_entry(ubi_wrk, &ubi->erase_works, list) {
 		if (ubi_is_erase_work(ubi_wrk)) {
 			wl_e = ubi_wrk->e;
 			ubi_assert(wl_e);
@@ -62,6 +62,9 @@
 /* Background thread name pattern */
 #define UBI_BGT_NAME_PATTERN "ubi_bgt%dd"
 
+/* Maximum number of background threads per UBI device */
+#define UBI_MAX_BGT_THREADS 4
+
 /*
  * This marker in the EBA table means that the LEB is um-mapped.
  * NOTE! It has to have the same value as %UBI_ALL.
@@ -348,6 +351,37 @@ struct ubi_volume_desc {
 
 struct ubi_wl_entry;
 
+/**
+ * struct ubi_wl_stats - statistics of the WL sub-system work queues.
+ * @erase_works: count of erase works done
+ * @erase_wait_ns: total time erase works spent queued
+ * @erase_wait_max_ns: longest time an erase work spent queued
+ * @erase_depth_max: highest count of pending erase works
+ * @other_works: count of wear-leveling and scrubbing works done
+ * @other_wait_ns: total time wear-leveling and scrubbing works spent queued
+ * @other_wait_max_ns: longest time a wear-leveling or scrubbing work spent
+ *                     queued
+ * @depth_max: highest count of pending works of any kind
+ * @free_waits: how many times a writer found no free PEB and had to wait
+ * @free_wait_ns: total time writers waited for a free PEB
+ * @free_wait_max_ns: longest time a writer waited for a free PEB
+ *
+ * All fields are protected by @ubi->wl_lock.
+ */
+struct ubi_wl_stats {
+	unsigned long erase_works;
+	u64 erase_wait_ns;
+	u64 erase_wait_max_ns;
+	int erase_depth_max;
+	unsigned long other_works;
+	u64 other_wait_ns;
+	u64 other_wait_max_ns;
+	int depth_max;
+	unsigned long free_waits;
+	u64 free_wait_ns;
+	u64 free_wait_max_ns;
+};
+
 /**
  * struct ubi_debug_info - debugging information for an UBI device.
  *
@@ -438,6 +472,8 @@ struct ubi_debug_info {
  * @pq_head: protection queue head
  * @wl_lock: protects the @used, @free, @pq, @pq_head, @lookuptbl, @move_from,
  *	     @move_to, @move_to_put @erase_pending, @wl_scheduled, @works,
+ *	     @erase_works, @works_count, @erase_works_count, @works_running,
+ *	     @wl_stats,
  *	     @erroneous, and @erroneous_peb_count fields
  * @move_mutex: serializes eraseblock moves
  * @work_sem: synchronizes the WL worker with use tasks
@@ -447,10 +483,16 @@ struct ubi_debug_info {
  * @move_from: physical eraseblock from where the data is being moved
  * @move_to: physical eraseblock where the data is being moved to
  * @move_to_put: if the "to" PEB was put
- * @works: list of pending works
- * @works_count: count of pending works
- * @bgt_thread: background thread description object
- * @thread_enabled: if the background thread is enabled
+ * @works: list of pending wear-leveling and scrubbing works
+ * @erase_works: list of pending erase works, done before @works
+ * @works_count: count of pending works in both lists
+ * @erase_works_count: count of pending erase works
+ * @works_running: count of works taken from the lists but not finished yet
+ * @works_wait: wait queue to wait for running works
+ * @wl_stats: work queue statistics
+ * @bgt_thread: background thread description objects
+ * @bgt_count: number of background threads in @bgt_thread
+ * @thread_enabled: if the background threads are enabled
  * @bgt_name: background thread name
  *
  * @flash_size: underlying MTD device size (in bytes)
@@ -550,8 +592,14 @@ struct ubi_device {
 	struct ubi_wl_entry *move_to;
 	int move_to_put;
 	struct list_head works;
+	struct list_head erase_works;
 	int works_count;
-	struct task_struct *bgt_thread;
+	int erase_works_count;
+	int works_running;
+	wait_queue_head_t works_wait;
+	struct ubi_wl_stats wl_stats;
+	struct task_struct *bgt_thread[UBI_MAX_BGT_THREADS];
+	int bgt_count;
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
 
@@ -713,6 +761,7 @@ struct ubi_attach_info {
  * @lnum: the logical eraseblock number
  * @torture: if the physical eraseblock has to be tortured
  * @anchor: produce a anchor PEB to by used by fastmap
+ * @queued: when the work was queued, for the statistics
  *
  * The @func pointer points to the worker function. If the @cancel argument is
  * not zero, the worker has to free the resources and exit immediately. The
@@ -728,6 +777,7 @@ struct ubi_work {
 	int lnum;
 	int torture;
 	int anchor;
+	u64 queued;
 };
 
 #include "debug.h"
@@ -212,12 +212,64 @@ static void wl_tree_add(struct ubi_wl_entry *e, struct rb_root *root)
 	rb_insert_color(&e->u.rb, root);
 }
 
+static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
+			int cancel);
+
+/**
+ * take_work - remove a work from the pending works lists.
+ * @ubi: UBI device description object
+ * @wrk: the work to remove
+ *
+ * This function has to be called with @ubi->wl_lock locked. The work is then
+ * counted as running until 'work_done()' is called. This function also
+ * accounts the time @wrk spent in the queue.
+ */
+static void take_work(struct ubi_device *ubi, struct ubi_work *wrk)
+{
+	struct ubi_wl_stats *st = &ubi->wl_stats;
+	u64 wait = local_clock() - wrk->queued;
+
+	list_del(&wrk->list);
+	ubi->works_count -= 1;
+	ubi_assert(ubi->works_count >= 0);
+	ubi->works_running += 1;
+
+	if (wrk->func == erase_worker) {
+		ubi->erase_works_count -= 1;
+		ubi_assert(ubi->erase_works_count >= 0);
+		st->erase_works += 1;
+		st->erase_wait_ns += wait;
+		if (wait > st->erase_wait_max_ns)
+			st->erase_wait_max_ns = wait;
+	} else {
+		st->other_works += 1;
+		st->other_wait_ns += wait;
+		if (wait > st->other_wait_max_ns)
+			st->other_wait_max_ns = wait;
+	}
+}
+
+/**
+ * work_done - account the end of a work taken by 'take_work()'.
+ * @ubi: UBI device description object
+ */
+static void work_done(struct ubi_device *ubi)
+{
+	spin_lock(&ubi->wl_lock);
+	ubi->works_running -= 1;
+	ubi_assert(ubi->works_running >= 0);
+	spin_unlock(&ubi->wl_lock);
+	wake_up_all(&ubi->works_wait);
+}
+
 /**
  * do_work - do one pending work.
  * @ubi: UBI device description object
  *
- * This function returns zero in case of success and a negative error code in
- * case of failure.
+ * Erase works are done before wear-leveling and scrubbing works, because they
+ * are what produces free PEBs for the writers, while wear-leveling consumes
+ * them. This function returns zero in case of success and a negative error
+ * code in case of failure.
  */
 static int do_work(struct ubi_device *ubi)
 {
@@ -234,16 +286,17 @@ static int do_work(struct ubi_device *ubi)
 	 */
 	down_read(&ubi->work_sem);
 	spin_lock(&ubi->wl_lock);
-	if (list_empty(&ubi->works)) {
+	if (!list_empty(&ubi->erase_works))
+		wrk = list_entry(ubi->erase_works.next, struct ubi_work, list);
+	else if (!list_empty(&ubi->works))
+		wrk = list_entry(ubi->works.next, struct ubi_work, list);
+	else {
 		spin_unlock(&ubi->wl_lock);
 		up_read(&ubi->work_sem);
 		return 0;
 	}
 
-	wrk = list_entry(ubi->works.next, struct ubi_work, list);
-	list_del(&wrk->list);
-	ubi->works_count -= 1;
-	ubi_assert(ubi->works_count >= 0);
+	take_work(ubi, wrk);
 	spin_unlock(&ubi->wl_lock);
 
 	/*
@@ -254,6 +307,7 @@ static int do_work(struct ubi_device *ubi)
 	err = wrk->func(ubi, wrk, 0);
 	if (err)
 		ubi_err("work failed with error code %d", err);
+	work_done(ubi);
 	up_read(&ubi->work_sem);
 
 	return err;
@@ -265,25 +319,39 @@ static int do_work(struct ubi_device *ubi)
  *
  * This function tries to make a free PEB by means of synchronous execution of
  * pending works. This may be needed if, for example the background thread is
- * disabled. Returns zero in case of success and a negative error code in case
- * of failure.
+ * disabled. If the queue runs empty while the background threads are still
+ * doing the works they took, it waits for them instead. The time the caller was
+ * blocked is accounted in @ubi->wl_stats. Returns zero in case of success and
+ * a negative error code in case of failure.
  */
 static int produce_free_peb(struct ubi_device *ubi)
 {
-	int err;
+	struct ubi_wl_stats *st = &ubi->wl_stats;
+	u64 start = local_clock(), wait;
+	int err = 0;
 
-	while (!ubi->free.rb_node) {
+	while (!ubi->free.rb_node && (ubi->works_count || ubi->works_running)) {
 		spin_unlock(&ubi->wl_lock);
 
-		dbg_wl("do one work synchronously");
-		err = do_work(ubi);
+		if (ubi->works_count) {
+			dbg_wl("do one work synchronously");
+			err = do_work(ubi);
+		} else
+			/* The background threads took all the pending works */
+			wait_event(ubi->works_wait, ubi->free.rb_node ||
+				   ubi->works_count || !ubi->works_running);
 
 		spin_lock(&ubi->wl_lock);
 		if (err)
-			return err;
+			break;
 	}
 
-	return 0;
+	wait = local_clock() - start;
+	st->free_waits += 1;
+	st->free_wait_ns += wait;
+	if (wait > st->free_wait_max_ns)
+		st->free_wait_max_ns = wait;
+	return err;
 }
 
 /**
@@ -506,9 +574,10 @@ static int __wl_get_peb(struct ubi_device *ubi)
 
 retry:
 	if (!ubi->free.rb_node) {
-		if (ubi->works_count == 0) {
+		if (ubi->works_count == 0 && ubi->works_running == 0) {
 			ubi_err("no free eraseblocks");
 			ubi_assert(list_empty(&ubi->works));
+			ubi_assert(list_empty(&ubi->erase_works));
 			return -ENOSPC;
 		}
 
@@ -828,22 +897,51 @@ repeat:
 	spin_unlock(&ubi->wl_lock);
 }
 
+/**
+ * wake_up_bgt - wake up background threads for the pending works.
+ * @ubi: UBI device description object
+ *
+ * Wakes up as many background threads as there are pending works, so that
+ * several erasures may be in flight at a time. This function has to be called
+ * with @ubi->wl_lock locked.
+ */
+static void wake_up_bgt(struct ubi_device *ubi)
+{
+	int i, n = min(ubi->works_count, ubi->bgt_count);
+
+	for (i = 0; i < n; i++)
+		wake_up_process(ubi->bgt_thread[i]);
+}
+
 /**
  * __schedule_ubi_work - schedule a work.
  * @ubi: UBI device description object
  * @wrk: the work to schedule
  *
- * This function adds a work defined by @wrk to the tail of the pending works
- * list. Can only be used of ubi->work_sem is already held in read mode!
+ * This function adds a work defined by @wrk to the tail of the pending erase
+ * works list if it is an erasure, and to the tail of the other pending works
+ * list otherwise. Can only be used of ubi->work_sem is already held in read
+ * mode!
  */
 static void __schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 {
+	struct ubi_wl_stats *st = &ubi->wl_stats;
+
 	spin_lock(&ubi->wl_lock);
-	list_add_tail(&wrk->list, &ubi->works);
+	wrk->queued = local_clock();
+	if (wrk->func == erase_worker) {
+		list_add_tail(&wrk->list, &ubi->erase_works);
+		ubi->erase_works_count += 1;
+		if (ubi->erase_works_count > st->erase_depth_max)
+			st->erase_depth_max = ubi->erase_works_count;
+	} else
+		list_add_tail(&wrk->list, &ubi->works);
 	ubi_assert(ubi->works_count >= 0);
 	ubi->works_count += 1;
+	if (ubi->works_count > st->depth_max)
+		st->depth_max = ubi->works_count;
 	if (ubi->thread_enabled && !ubi_dbg_is_bgt_disabled(ubi))
-		wake_up_process(ubi->bgt_thread);
+		wake_up_bgt(ubi);
 	spin_unlock(&ubi->wl_lock);
 }
 
@@ -862,9 +960,6 @@ static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	up_read(&ubi->work_sem);
 }
 
-static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
-			int cancel);
-
 #ifdef CONFIG_MTD_UBI_FASTMAP
 /**
  * ubi_is_erase_work - checks whether a work is erase work.
@@ -1687,6 +1782,26 @@ retry:
 	return ensure_wear_leveling(ubi, 0);
 }
 
+/**
+ * find_work - find a pending work for a LEB.
+ * @list: the pending works list to search
+ * @vol_id: the volume id, or %UBI_ALL
+ * @lnum: the logical eraseblock number, or %UBI_ALL
+ *
+ * This function has to be called with @ubi->wl_lock locked. Returns the first
+ * matching work or %NULL if there is none.
+ */
+static struct ubi_work *find_work(struct list_head *list, int vol_id, int lnum)
+{
+	struct ubi_work *wrk;
+
+	list_for_each_entry(wrk, list, list)
+		if ((vol_id == UBI_ALL || wrk->vol_id == vol_id) &&
+		    (lnum == UBI_ALL || wrk->lnum == lnum))
+			return wrk;
+	return NULL;
+}
+
 /**
  * ubi_wl_flush - flush all pending works.
  * @ubi: UBI device description object
@@ -1717,27 +1832,22 @@ int ubi_wl_flush(struct ubi_device *ubi, int vol_id, int lnum)
 
 		down_read(&ubi->work_sem);
 		spin_lock(&ubi->wl_lock);
-		list_for_each_entry(wrk, &ubi->works, list) {
-			if ((vol_id == UBI_ALL || wrk->vol_id == vol_id) &&
-			    (lnum == UBI_ALL || wrk->lnum == lnum)) {
-				list_del(&wrk->list);
-				ubi->works_count -= 1;
-				ubi_assert(ubi->works_count >= 0);
-				spin_unlock(&ubi->wl_lock);
-
-				err = wrk->func(ubi, wrk, 0);
-				if (err) {
-					up_read(&ubi->work_sem);
-					return err;
-				}
-
-				spin_lock(&ubi->wl_lock);
-				found = 1;
-				break;
-			}
+		wrk = find_work(&ubi->erase_works, vol_id, lnum);
+		if (!wrk)
+			wrk = find_work(&ubi->works, vol_id, lnum);
+		if (wrk) {
+			take_work(ubi, wrk);
+			found = 1;
 		}
 		spin_unlock(&ubi->wl_lock);
+
+		if (found) {
+			err = wrk->func(ubi, wrk, 0);
+			work_done(ubi);
+		}
 		up_read(&ubi->work_sem);
+		if (err)
+			return err;
 	}
 
 	/*
@@ -1791,7 +1901,7 @@ int ubi_thread(void *u)
 	struct ubi_device *ubi = u;
 
 	ubi_msg("background thread \"%s\" started, PID %d",
-		ubi->bgt_name, task_pid_nr(current));
+		current->comm, task_pid_nr(current));
 
 	set_freezable();
 	for (;;) {
@@ -1804,7 +1914,7 @@ int ubi_thread(void *u)
 			continue;
 
 		spin_lock(&ubi->wl_lock);
-		if (list_empty(&ubi->works) || ubi->ro_mode ||
+		if (ubi->works_count == 0 || ubi->ro_mode ||
 		    !ubi->thread_enabled || ubi_dbg_is_bgt_disabled(ubi)) {
 			set_current_state(TASK_INTERRUPTIBLE);
 			spin_unlock(&ubi->wl_lock);
@@ -1834,7 +1944,7 @@ int ubi_thread(void *u)
 		cond_resched();
 	}
 
-	dbg_wl("background thread \"%s\" is killed", ubi->bgt_name);
+	dbg_wl("background thread \"%s\" is killed", current->comm);
 	return 0;
 }
 
@@ -1844,14 +1954,18 @@ int ubi_thread(void *u)
  */
 static void cancel_pending(struct ubi_device *ubi)
 {
-	while (!list_empty(&ubi->works)) {
-		struct ubi_work *wrk;
+	struct ubi_work *wrk;
 
-		wrk = list_entry(ubi->works.next, struct ubi_work, list);
-		list_del(&wrk->list);
+	while (ubi->works_count) {
+		if (!list_empty(&ubi->erase_works))
+			wrk = list_entry(ubi->erase_works.next, struct ubi_work,
+					 list);
+		else
+			wrk = list_entry(ubi->works.next, struct ubi_work,
+					 list);
+		take_work(ubi, wrk);
 		wrk->func(ubi, wrk, 1);
-		ubi->works_count -= 1;
-		ubi_assert(ubi->works_count >= 0);
+		ubi->works_running -= 1;
 	}
 }
 
@@ -1877,6 +1991,8 @@ int ubi_wl_init(struct ubi_device *ubi, struct ubi_attach_info *ai)
 	init_rwsem(&ubi->work_sem);
 	ubi->max_ec = ai->max_ec;
 	INIT_LIST_HEAD(&ubi->works);
+	INIT_LIST_HEAD(&ubi->erase_works);
+	init_waitqueue_head(&ubi->works_wait);
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	INIT_WORK(&ubi->fm_work, update_fastmap_work_fn);
 #endif
@@ -61,6 +61,8 @@ disclaimer.
 #include <linux/of_address.h>
 #include <linux/clk.h>
 #include <linux/phy.h>
+#include <linux/cpuidle.h>
+#include <linux/cpufreq.h>
 #endif /* CONFIG_OF */
 
 #ifdef CONFIG_MV_NETA_TXDONE_IN_HRTIMER
@@ -1741,6 +1743,8 @@ static inline int mv_eth_rx(struct eth_port *pp, int rx_todo, int rxq, struct na
 	rx_done = mvNetaRxqBusyDescNumGet(pp->port, rxq);
 	mvOsCacheIoSync(pp->dev->dev.parent);
 
+	cpufreq_report_net_load(rx_done * 100 / pp->rxq_ctrl[rxq].rxq_size);
+
 	if (rx_todo > rx_done)
 		rx_todo = rx_done;
 
@@ -3110,6 +3114,10 @@ int mv_eth_poll(struct napi_struct *napi, int budget)
 	if (pp->rx_adaptive_coal_cfg)
 		pp->rx_rate_pkts += rx_done;
 
+	/* NAPI budget exhausted - ask cpufreq for more headroom */
+	if (budget <= 0)
+		cpufreq_report_net_load(100);
+
 	STAT_DIST((rx_done < pp->dist_stats.rx_dist_size) ? pp->dist_stats.rx_dist[rx_done]++ : 0);
 
 #ifdef CONFIG_MV_NETA_DEBUG_CODE
@@ -3132,6 +3140,10 @@ int mv_eth_poll(struct napi_struct *napi, int budget)
 		if (pp->rx_adaptive_coal_cfg)
 			mv_eth_adaptive_rx_update(pp);
 
+		/* with traffic flowing, the RX time coalescing bounds the next wakeup */
+		if (rx_done)
+			cpuidle_wakeup_hint(pp->rx_time_coal_cfg);
+
 		if (!(pp->flags & MV_ETH_F_IFCAP_NETMAP)) {
 			local_irq_save(flags);
 
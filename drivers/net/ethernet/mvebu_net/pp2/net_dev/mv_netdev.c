@@ -66,6 +66,7 @@ disclaimer.
 #include <linux/of_address.h>
 #include <linux/clk.h>
 #include <linux/phy.h>
+#include <linux/cpuidle.h>
 #endif /* CONFIG_OF */
 
 #ifdef CONFIG_MV_PP2_TXDONE_IN_HRTIMER
@@ -3313,6 +3314,10 @@ int mv_pp2_poll(struct napi_struct *napi, int budget)
 		if (pp->rx_adaptive_coal_cfg)
 			mv_pp2_adaptive_rx_update(pp);
 
+		/* with traffic flowing, the RX time coalescing bounds the next wakeup */
+		if (rx_done)
+			cpuidle_wakeup_hint(pp->rx_time_coal_cfg);
+
 		/* Enable interrupts for all cpus belong to this group */
 		if (!(pp->flags & MV_ETH_F_IFCAP_NETMAP)) {
 			wmb();
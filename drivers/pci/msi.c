@@ -69,15 +69,29 @@ int __weak arch_msi_check_device(struct pci_dev *dev, int nvec, int type)
 
 int __weak arch_setup_msi_irqs(struct pci_dev *dev, int nvec, int type)
 {
+	struct msi_chip *chip = dev->bus->msi;
 	struct msi_desc *entry;
-	int ret;
+	int i, ret;
 
 	/*
 	 * If an architecture wants to support multiple MSI, it needs to
-	 * override arch_setup_msi_irqs()
+	 * override arch_setup_msi_irqs() or provide a msi_chip that can
+	 * allocate a block of vectors.
 	 */
-	if (type == PCI_CAP_ID_MSI && nvec > 1)
-		return 1;
+	if (type == PCI_CAP_ID_MSI && nvec > 1) {
+		if (!chip || !chip->setup_irqs)
+			return 1;
+
+		entry = list_first_entry(&dev->msi_list, struct msi_desc, list);
+		ret = chip->setup_irqs(chip, dev, entry, nvec);
+		if (ret)
+			return ret;
+
+		for (i = 0; i < (1 << entry->msi_attrib.multiple); i++)
+			irq_set_chip_data(entry->irq + i, chip);
+
+		return 0;
+	}
 
 	list_for_each_entry(entry, &dev->msi_list, list) {
 		ret = arch_setup_msi_irq(dev, entry);
@@ -0,0 +1,261 @@
+/*
+ * Compressed RAM block device - compression streams
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ *
+ * Every CPU gets its own compression stream, so that writers reclaiming
+ * on different CPUs do not wait for each other. If the per-CPU streams
+ * cannot be allocated, a single stream shared by all writers is used.
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/percpu.h>
+#include <linux/lzo.h>
+#include <linux/lz4.h>
+
+#include "zcomp.h"
+
+static int zcomp_lzo_compress(const unsigned char *src, unsigned char *dst,
+			      size_t *dst_len, void *workmem)
+{
+	int ret = lzo1x_1_compress(src, PAGE_SIZE, dst, dst_len, workmem);
+
+	return ret == LZO_E_OK ? 0 : ret;
+}
+
+static int zcomp_lzo_decompress(const unsigned char *src, size_t src_len,
+				unsigned char *dst)
+{
+	size_t dst_len = PAGE_SIZE;
+	int ret = lzo1x_decompress_safe(src, src_len, dst, &dst_len);
+
+	return ret == LZO_E_OK ? 0 : ret;
+}
+
+static const struct zcomp_backend zcomp_lzo = {
+	.name = "lzo",
+	.workmem_size = LZO1X_MEM_COMPRESS,
+	.compress = zcomp_lzo_compress,
+	.decompress = zcomp_lzo_decompress,
+};
+
+#ifdef CONFIG_ZRAM_LZ4_COMPRESS
+static int zcomp_lz4_compress(const unsigned char *src, unsigned char *dst,
+			      size_t *dst_len, void *workmem)
+{
+	*dst_len = 2 * PAGE_SIZE;
+	return lz4_compress(src, PAGE_SIZE, dst, dst_len, workmem);
+}
+
+static int zcomp_lz4_decompress(const unsigned char *src, size_t src_len,
+				unsigned char *dst)
+{
+	size_t dst_len = PAGE_SIZE;
+
+	return lz4_decompress_unknownoutputsize(src, src_len, dst, &dst_len);
+}
+
+static const struct zcomp_backend zcomp_lz4 = {
+	.name = "lz4",
+	.workmem_size = LZ4_MEM_COMPRESS,
+	.compress = zcomp_lz4_compress,
+	.decompress = zcomp_lz4_decompress,
+};
+#endif
+
+static const struct zcomp_backend *backends[] = {
+	&zcomp_lzo,
+#ifdef CONFIG_ZRAM_LZ4_COMPRESS
+	&zcomp_lz4,
+#endif
+	NULL
+};
+
+static const struct zcomp_backend *find_backend(const char *comp)
+{
+	int i;
+
+	for (i = 0; backends[i]; i++)
+		if (sysfs_streq(comp, backends[i]->name))
+			return backends[i];
+	return NULL;
+}
+
+/* show available compressors, the current one in brackets */
+ssize_t zcomp_available_show(const char *comp, char *buf)
+{
+	ssize_t sz = 0;
+	int i;
+
+	for (i = 0; backends[i]; i++) {
+		if (!strcmp(comp, backends[i]->name))
+			sz += sprintf(buf + sz, "[%s] ", backends[i]->name);
+		else
+			sz += sprintf(buf + sz, "%s ", backends[i]->name);
+	}
+	sz += sprintf(buf + sz, "\n");
+	return sz;
+}
+
+bool zcomp_available_algorithm(const char *comp)
+{
+	return find_backend(comp) != NULL;
+}
+
+static int zcomp_strm_init(struct zcomp *comp, struct zcomp_strm *zstrm)
+{
+	mutex_init(&zstrm->lock);
+	zstrm->workmem = kzalloc(comp->backend->workmem_size, GFP_KERNEL);
+	/* compressed data may be bigger than the page it came from */
+	zstrm->buffer = (void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 1);
+	if (!zstrm->workmem || !zstrm->buffer)
+		return -ENOMEM;
+	return 0;
+}
+
+static void zcomp_strm_free(struct zcomp_strm *zstrm)
+{
+	kfree(zstrm->workmem);
+	free_pages((unsigned long)zstrm->buffer, 1);
+}
+
+static void zcomp_strm_free_percpu(struct zcomp *comp)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		zcomp_strm_free(per_cpu_ptr(comp->strm, cpu));
+	free_percpu(comp->strm);
+	comp->strm = NULL;
+}
+
+static int zcomp_strm_alloc_percpu(struct zcomp *comp)
+{
+	int cpu;
+
+	/* a single CPU does not need more than the single stream */
+	if (num_possible_cpus() == 1)
+		return -EINVAL;
+
+	comp->strm = alloc_percpu(struct zcomp_strm);
+	if (!comp->strm)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		if (zcomp_strm_init(comp, per_cpu_ptr(comp->strm, cpu))) {
+			zcomp_strm_free_percpu(comp);
+			return -ENOMEM;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Create a compressor using the @comp algorithm. Returns NULL if the
+ * algorithm is unknown or memory is short.
+ */
+struct zcomp *zcomp_create(const char *comp)
+{
+	struct zcomp *zcomp;
+
+	zcomp = kzalloc(sizeof(struct zcomp), GFP_KERNEL);
+	if (!zcomp)
+		return NULL;
+
+	zcomp->backend = find_backend(comp);
+	if (!zcomp->backend)
+		goto out_free;
+
+	if (zcomp_strm_alloc_percpu(zcomp) == 0)
+		return zcomp;
+
+	if (num_possible_cpus() > 1)
+		pr_warn("Cannot allocate per-CPU %s streams, using one\n",
+			zcomp->backend->name);
+
+	zcomp->single = kzalloc(sizeof(struct zcomp_strm), GFP_KERNEL);
+	if (!zcomp->single)
+		goto out_free;
+	if (zcomp_strm_init(zcomp, zcomp->single)) {
+		zcomp_strm_free(zcomp->single);
+		kfree(zcomp->single);
+		goto out_free;
+	}
+	return zcomp;
+
+out_free:
+	kfree(zcomp);
+	return NULL;
+}
+
+void zcomp_destroy(struct zcomp *comp)
+{
+	if (comp->strm)
+		zcomp_strm_free_percpu(comp);
+	if (comp->single) {
+		zcomp_strm_free(comp->single);
+		kfree(comp->single);
+	}
+	kfree(comp);
+}
+
+/*
+ * Get a compression stream. The writer may sleep while it holds it (e.g.
+ * in zs_malloc()), so the streams are not tied to their CPUs with
+ * preemption disabled: the stream of this CPU is taken if it is idle,
+ * otherwise the first idle one of another CPU, and only if all are busy
+ * do we wait for the stream of this CPU.
+ */
+struct zcomp_strm *zcomp_strm_find(struct zcomp *comp)
+{
+	struct zcomp_strm *zstrm;
+	int cpu;
+
+	if (!comp->strm) {
+		mutex_lock(&comp->single->lock);
+		return comp->single;
+	}
+
+	zstrm = per_cpu_ptr(comp->strm, raw_smp_processor_id());
+	if (mutex_trylock(&zstrm->lock))
+		return zstrm;
+
+	for_each_possible_cpu(cpu) {
+		struct zcomp_strm *other = per_cpu_ptr(comp->strm, cpu);
+
+		if (other != zstrm && mutex_trylock(&other->lock))
+			return other;
+	}
+
+	mutex_lock(&zstrm->lock);
+	return zstrm;
+}
+
+void zcomp_strm_release(struct zcomp *comp, struct zcomp_strm *zstrm)
+{
+	mutex_unlock(&zstrm->lock);
+}
+
+/* Compress one page from @src into @zstrm->buffer */
+int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
+		   const unsigned char *src, size_t *dst_len)
+{
+	return comp->backend->compress(src, zstrm->buffer, dst_len,
+				       zstrm->workmem);
+}
+
+/* Decompress @src into the page at @dst, needs no stream */
+int zcomp_decompress(struct zcomp *comp, const unsigned char *src,
+		     size_t src_len, unsigned char *dst)
+{
+	return comp->backend->decompress(src, src_len, dst);
+}
@@ -0,0 +1,56 @@
+/*
+ * Compressed RAM block device - compression streams
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ */
+
+#ifndef _ZCOMP_H_
+#define _ZCOMP_H_
+
+#include <linux/mutex.h>
+
+struct zcomp_backend {
+	const char *name;
+	size_t workmem_size;
+	/* @dst is two pages, @dst_len returns the compressed size */
+	int (*compress)(const unsigned char *src, unsigned char *dst,
+			size_t *dst_len, void *workmem);
+	/* decompresses into exactly one page */
+	int (*decompress)(const unsigned char *src, size_t src_len,
+			  unsigned char *dst);
+};
+
+/* Compression buffer and working memory, used by one writer at a time */
+struct zcomp_strm {
+	struct mutex lock;
+	void *buffer;	/* two pages: compressed data may be bigger */
+	void *workmem;
+};
+
+struct zcomp {
+	const struct zcomp_backend *backend;
+	/* one stream per possible CPU, or NULL if they could not be had */
+	struct zcomp_strm __percpu *strm;
+	/* the only stream if @strm is NULL */
+	struct zcomp_strm *single;
+};
+
+ssize_t zcomp_available_show(const char *comp, char *buf);
+bool zcomp_available_algorithm(const char *comp);
+
+struct zcomp *zcomp_create(const char *comp);
+void zcomp_destroy(struct zcomp *comp);
+
+struct zcomp_strm *zcomp_strm_find(struct zcomp *comp);
+void zcomp_strm_release(struct zcomp *comp, struct zcomp_strm *zstrm);
+
+int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
+		   const unsigned char *src, size_t *dst_len);
+int zcomp_decompress(struct zcomp *comp, const unsigned char *src,
+		     size_t src_len, unsigned char *dst);
+
+#endif /* _ZCOMP_H_ */
@@ -22,14 +22,15 @@
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <linux/bio.h>
+#include <linux/bitmap.h>
 #include <linux/bitops.h>
 #include <linux/blkdev.h>
 #include <linux/buffer_head.h>
 #include <linux/device.h>
 #include <linux/genhd.h>
 #include <linux/highmem.h>
+#include <linux/ktime.h>
 #include <linux/slab.h>
-#include <linux/lzo.h>
 #include <linux/string.h>
 #include <linux/vmalloc.h>
 
@@ -61,6 +62,18 @@ static void zram_stat64_inc(struct zram *zram, u64 *v)
 	zram_stat64_add(zram, v, 1);
 }
 
+/* Account one (de)compression which started at @start */
+static void zram_stat64_time(struct zram *zram, u64 *ops, u64 *ns,
+			     ktime_t start)
+{
+	s64 delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	spin_lock(&zram->stat64_lock);
+	*ops = *ops + 1;
+	*ns = *ns + delta;
+	spin_unlock(&zram->stat64_lock);
+}
+
 static int zram_test_flag(struct zram_meta *meta, u32 index,
 			enum zram_pageflags flag)
 {
@@ -94,12 +107,83 @@ static int page_zero_filled(void *ptr)
 	return 1;
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static void zram_free_bdev_block(struct zram *zram, unsigned long blk)
+{
+	spin_lock(&zram->bitmap_lock);
+	WARN_ON_ONCE(!test_bit(blk, zram->bitmap));
+	clear_bit(blk, zram->bitmap);
+	spin_unlock(&zram->bitmap_lock);
+}
+
+/* Synchronously read or write one page at block @blk of the backing device */
+static int zram_bdev_rw(struct zram *zram, struct page *page,
+			unsigned long blk, int rw)
+{
+	struct bio *bio;
+	int ret;
+
+	bio = bio_alloc(GFP_NOIO, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_sector = (sector_t)blk << SECTORS_PER_PAGE_SHIFT;
+	bio->bi_bdev = zram->bdev;
+	if (!bio_add_page(bio, page, PAGE_SIZE, 0)) {
+		bio_put(bio);
+		return -EIO;
+	}
+
+	ret = submit_bio_wait(rw, bio);
+	bio_put(bio);
+	return ret;
+}
+#else
+static inline void zram_free_bdev_block(struct zram *zram, unsigned long blk)
+{
+}
+
+static inline int zram_bdev_rw(struct zram *zram, struct page *page,
+			       unsigned long blk, int rw)
+{
+	return -EIO;
+}
+#endif
+
+/* Read page @index from the backing device into @mem */
+static int zram_read_from_bdev(struct zram *zram, char *mem, u32 index)
+{
+	struct page *page;
+	int ret;
+
+	page = alloc_page(GFP_NOIO);
+	if (!page)
+		return -ENOMEM;
+
+	ret = zram_bdev_rw(zram, page, zram->meta->table[index].handle, READ);
+	if (!ret)
+		memcpy(mem, page_address(page), PAGE_SIZE);
+	__free_page(page);
+	return ret;
+}
+
 static void zram_free_page(struct zram *zram, size_t index)
 {
 	struct zram_meta *meta = zram->meta;
 	unsigned long handle = meta->table[index].handle;
 	u16 size = meta->table[index].size;
 
+	zram_clear_flag(meta, index, ZRAM_IDLE);
+	zram_clear_flag(meta, index, ZRAM_UNDER_WB);
+
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		zram_free_bdev_block(zram, handle);
+		zram_clear_flag(meta, index, ZRAM_WB);
+		zram->stats.pages_wb--;
+		meta->table[index].handle = 0;
+		return;
+	}
+
 	if (unlikely(!handle)) {
 		/*
 		 * No memory is allocated for zero filled pages.
@@ -145,29 +229,44 @@ static inline int is_partial_io(struct bio_vec *bvec)
 	return bvec->bv_len != PAGE_SIZE;
 }
 
+/* Must be called with zram->lock held */
 static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 {
-	int ret = LZO_E_OK;
-	size_t clen = PAGE_SIZE;
+	int ret = 0;
 	unsigned char *cmem;
 	struct zram_meta *meta = zram->meta;
 	unsigned long handle = meta->table[index].handle;
+	ktime_t start;
 
 	if (!handle || zram_test_flag(meta, index, ZRAM_ZERO)) {
 		memset(mem, 0, PAGE_SIZE);
 		return 0;
 	}
 
+	if (zram_test_flag(meta, index, ZRAM_WB)) {
+		ret = zram_read_from_bdev(zram, mem, index);
+		if (unlikely(ret)) {
+			pr_err("Backing device read failed! err=%d, page=%u\n",
+			       ret, index);
+			zram_stat64_inc(zram, &zram->stats.failed_reads);
+		}
+		return ret;
+	}
+
 	cmem = zs_map_object(meta->mem_pool, handle, ZS_MM_RO);
 	if (meta->table[index].size == PAGE_SIZE)
 		memcpy(mem, cmem, PAGE_SIZE);
-	else
-		ret = lzo1x_decompress_safe(cmem, meta->table[index].size,
-						mem, &clen);
+	else {
+		start = ktime_get();
+		ret = zcomp_decompress(zram->comp, cmem,
+				       meta->table[index].size, mem);
+		zram_stat64_time(zram, &zram->stats.num_decompr,
+				 &zram->stats.decompr_ns, start);
+	}
 	zs_unmap_object(meta->mem_pool, handle);
 
 	/* Should NEVER happen. Return bio error if it does. */
-	if (unlikely(ret != LZO_E_OK)) {
+	if (unlikely(ret)) {
 		pr_err("Decompression failed! err=%d, page=%u\n", ret, index);
 		zram_stat64_inc(zram, &zram->stats.failed_reads);
 		return ret;
@@ -179,7 +278,7 @@ static int zram_decompress_page(struct zram *zram, char *mem, u32 index)
 static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 			  u32 index, int offset, struct bio *bio)
 {
-	int ret;
+	int ret, wb;
 	struct page *page;
 	unsigned char *user_mem, *uncmem = NULL;
 	struct zram_meta *meta = zram->meta;
@@ -191,12 +290,33 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 		return 0;
 	}
 
-	if (is_partial_io(bvec))
+	/*
+	 * A read makes the page not idle. zram->lock is only held shared
+	 * here, but concurrent readers can at most all clear the flag.
+	 */
+	if (zram_test_flag(meta, index, ZRAM_IDLE))
+		zram_clear_flag(meta, index, ZRAM_IDLE);
+
+	/*
+	 * Reading from the backing device sleeps, so it cannot go to the
+	 * atomically mapped page.
+	 */
+	wb = zram_test_flag(meta, index, ZRAM_WB);
+
+	if (is_partial_io(bvec) || wb)
 		/* Use  a temporary buffer to decompress the page */
 		uncmem = kmalloc(PAGE_SIZE, GFP_NOIO);
 
+	if (wb && uncmem) {
+		ret = zram_decompress_page(zram, uncmem, index);
+		if (unlikely(ret)) {
+			kfree(uncmem);
+			return ret;
+		}
+	}
+
 	user_mem = kmap_atomic(page);
-	if (!is_partial_io(bvec))
+	if (!is_partial_io(bvec) && !wb)
 		uncmem = user_mem;
 
 	if (!uncmem) {
@@ -205,12 +325,14 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 		goto out_cleanup;
 	}
 
-	ret = zram_decompress_page(zram, uncmem, index);
-	/* Should NEVER happen. Return bio error if it does. */
-	if (unlikely(ret != LZO_E_OK))
-		goto out_cleanup;
+	if (!wb) {
+		ret = zram_decompress_page(zram, uncmem, index);
+		/* Should NEVER happen. Return bio error if it does. */
+		if (unlikely(ret))
+			goto out_cleanup;
+	}
 
-	if (is_partial_io(bvec))
+	if (is_partial_io(bvec) || wb)
 		memcpy(user_mem + bvec->bv_offset, uncmem + offset,
 				bvec->bv_len);
 
@@ -218,23 +340,32 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	ret = 0;
 out_cleanup:
 	kunmap_atomic(user_mem);
-	if (is_partial_io(bvec))
+	if (is_partial_io(bvec) || wb)
 		kfree(uncmem);
 	return ret;
 }
 
+/*
+ * Only the table update runs under zram->lock, compression uses a stream
+ * of its own, so writers on different CPUs compress in parallel. A partial
+ * write is a read-modify-write of the whole page and holds zram->lock from
+ * the read to the table update, so that concurrent partial writes to the
+ * same page cannot lose each other's data.
+ */
 static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			   int offset)
 {
 	int ret = 0;
+	int locked = 0;
 	size_t clen;
 	unsigned long handle;
 	struct page *page;
 	unsigned char *user_mem, *cmem, *src, *uncmem = NULL;
 	struct zram_meta *meta = zram->meta;
+	struct zcomp_strm *zstrm = NULL;
+	ktime_t start;
 
 	page = bvec->bv_page;
-	src = meta->compress_buffer;
 
 	if (is_partial_io(bvec)) {
 		/*
@@ -246,19 +377,14 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 			ret = -ENOMEM;
 			goto out;
 		}
+		down_write(&zram->lock);
+		locked = 1;
 		ret = zram_decompress_page(zram, uncmem, index);
 		if (ret)
 			goto out;
 	}
 
-	/*
-	 * System overwrites unused sectors. Free memory associated
-	 * with this sector now.
-	 */
-	if (meta->table[index].handle ||
-	    zram_test_flag(meta, index, ZRAM_ZERO))
-		zram_free_page(zram, index);
-
+	zstrm = zcomp_strm_find(zram->comp);
 	user_mem = kmap_atomic(page);
 
 	if (is_partial_io(bvec)) {
@@ -271,15 +397,27 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 	}
 
 	if (page_zero_filled(uncmem)) {
-		kunmap_atomic(user_mem);
+		if (user_mem)
+			kunmap_atomic(user_mem);
+		if (!locked)
+			down_write(&zram->lock);
+		/*
+		 * System overwrites unused sectors. Free memory associated
+		 * with this sector now.
+		 */
+		zram_free_page(zram, index);
 		zram->stats.pages_zero++;
 		zram_set_flag(meta, index, ZRAM_ZERO);
+		if (!locked)
+			up_write(&zram->lock);
 		ret = 0;
 		goto out;
 	}
 
-	ret = lzo1x_1_compress(uncmem, PAGE_SIZE, src, &clen,
-			       meta->compress_workmem);
+	start = ktime_get();
+	ret = zcomp_compress(zram->comp, zstrm, uncmem, &clen);
+	zram_stat64_time(zram, &zram->stats.num_compr, &zram->stats.compr_ns,
+			 start);
 
 	if (!is_partial_io(bvec)) {
 		kunmap_atomic(user_mem);
@@ -287,13 +425,13 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 		uncmem = NULL;
 	}
 
-	if (unlikely(ret != LZO_E_OK)) {
+	if (unlikely(ret)) {
 		pr_err("Compression failed! err=%d\n", ret);
 		goto out;
 	}
 
+	src = zstrm->buffer;
 	if (unlikely(clen > max_zpage_size)) {
-		zram->stats.bad_compress++;
 		clen = PAGE_SIZE;
 		src = NULL;
 		if (is_partial_io(bvec))
@@ -317,16 +455,35 @@ static int zram_bvec_write(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	zs_unmap_object(meta->mem_pool, handle);
 
+	zcomp_strm_release(zram->comp, zstrm);
+	zstrm = NULL;
+
+	if (!locked)
+		down_write(&zram->lock);
+	/*
+	 * System overwrites unused sectors. Free memory associated
+	 * with this sector now.
+	 */
+	zram_free_page(zram, index);
+
 	meta->table[index].handle = handle;
 	meta->table[index].size = clen;
 
 	/* Update stats */
 	zram_stat64_add(zram, &zram->stats.compr_size, clen);
 	zram->stats.pages_stored++;
+	if (clen > max_zpage_size)
+		zram->stats.bad_compress++;
 	if (clen <= PAGE_SIZE / 2)
 		zram->stats.good_compress++;
+	if (!locked)
+		up_write(&zram->lock);
 
 out:
+	if (zstrm)
+		zcomp_strm_release(zram->comp, zstrm);
+	if (locked)
+		up_write(&zram->lock);
 	if (is_partial_io(bvec))
 		kfree(uncmem);
 
@@ -345,9 +502,7 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 		ret = zram_bvec_read(zram, bvec, index, offset, bio);
 		up_read(&zram->lock);
 	} else {
-		down_write(&zram->lock);
 		ret = zram_bvec_write(zram, bvec, index, offset);
-		up_write(&zram->lock);
 	}
 
 	return ret;
@@ -465,11 +620,75 @@ error:
 	bio_io_error(bio);
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+static void zram_reset_backing_dev(struct zram *zram)
+{
+	if (!zram->bdev)
+		return;
+
+	blkdev_put(zram->bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+	zram->bdev = NULL;
+	kfree(zram->backing_dev);
+	zram->backing_dev = NULL;
+	vfree(zram->bitmap);
+	zram->bitmap = NULL;
+	zram->nr_blocks = 0;
+}
+
+/*
+ * Set the block device at @path up as backing device. Must be called with
+ * zram->init_lock held for writing, before the disk size is set.
+ */
+int zram_set_backing_dev(struct zram *zram, const char *path)
+{
+	struct block_device *bdev;
+	unsigned long nr_blocks, *bitmap;
+	char *name;
+
+	name = kstrdup(path, GFP_KERNEL);
+	if (!name)
+		return -ENOMEM;
+
+	bdev = blkdev_get_by_path(path, FMODE_READ | FMODE_WRITE | FMODE_EXCL,
+				  zram);
+	if (IS_ERR(bdev)) {
+		kfree(name);
+		return PTR_ERR(bdev);
+	}
+
+	nr_blocks = i_size_read(bdev->bd_inode) >> PAGE_SHIFT;
+	bitmap = vzalloc(BITS_TO_LONGS(nr_blocks) * sizeof(long));
+	if (nr_blocks < 2 || !bitmap) {
+		vfree(bitmap);
+		blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+		kfree(name);
+		return nr_blocks < 2 ? -EINVAL : -ENOMEM;
+	}
+	/* Block 0 is never used, so that handle 0 still means "no page" */
+	set_bit(0, bitmap);
+
+	zram_reset_backing_dev(zram);
+	zram->bdev = bdev;
+	zram->backing_dev = name;
+	zram->nr_blocks = nr_blocks;
+	zram->bitmap = bitmap;
+
+	pr_info("Set up %s as backing device, %lu pages\n", name, nr_blocks);
+	return 0;
+}
+#else
+static inline void zram_reset_backing_dev(struct zram *zram)
+{
+}
+#endif
+
 static void __zram_reset_device(struct zram *zram)
 {
 	size_t index;
 	struct zram_meta *meta;
 
+	zram_reset_backing_dev(zram);
+
 	if (!zram->init_done)
 		return;
 
@@ -479,7 +698,7 @@ static void __zram_reset_device(struct zram *zram)
 	/* Free all pages that are still in this zram device */
 	for (index = 0; index < zram->disksize >> PAGE_SHIFT; index++) {
 		unsigned long handle = meta->table[index].handle;
-		if (!handle)
+		if (!handle || zram_test_flag(meta, index, ZRAM_WB))
 			continue;
 
 		zs_free(meta->mem_pool, handle);
@@ -487,6 +706,8 @@ static void __zram_reset_device(struct zram *zram)
 
 	zram_meta_free(zram->meta);
 	zram->meta = NULL;
+	zcomp_destroy(zram->comp);
+	zram->comp = NULL;
 	/* Reset stats */
 	memset(&zram->stats, 0, sizeof(zram->stats));
 
@@ -504,8 +725,6 @@ void zram_reset_device(struct zram *zram)
 void zram_meta_free(struct zram_meta *meta)
 {
 	zs_destroy_pool(meta->mem_pool);
-	kfree(meta->compress_workmem);
-	free_pages((unsigned long)meta->compress_buffer, 1);
 	vfree(meta->table);
 	kfree(meta);
 }
@@ -517,22 +736,11 @@ struct zram_meta *zram_meta_alloc(u64 disksize)
 	if (!meta)
 		goto out;
 
-	meta->compress_workmem = kzalloc(LZO1X_MEM_COMPRESS, GFP_KERNEL);
-	if (!meta->compress_workmem)
-		goto free_meta;
-
-	meta->compress_buffer =
-		(void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 1);
-	if (!meta->compress_buffer) {
-		pr_err("Error allocating compressor buffer space\n");
-		goto free_workmem;
-	}
-
 	num_pages = disksize >> PAGE_SHIFT;
 	meta->table = vzalloc(num_pages * sizeof(*meta->table));
 	if (!meta->table) {
 		pr_err("Error allocating zram address table\n");
-		goto free_buffer;
+		goto free_meta;
 	}
 
 	meta->mem_pool = zs_create_pool(GFP_NOIO | __GFP_HIGHMEM);
@@ -545,10 +753,6 @@ struct zram_meta *zram_meta_alloc(u64 disksize)
 
 free_table:
 	vfree(meta->table);
-free_buffer:
-	free_pages((unsigned long)meta->compress_buffer, 1);
-free_workmem:
-	kfree(meta->compress_workmem);
 free_meta:
 	kfree(meta);
 	meta = NULL;
@@ -556,7 +760,8 @@ out:
 	return meta;
 }
 
-void zram_init_device(struct zram *zram, struct zram_meta *meta)
+void zram_init_device(struct zram *zram, struct zram_meta *meta,
+		      struct zcomp *comp)
 {
 	if (zram->disksize > 2 * (totalram_pages << PAGE_SHIFT)) {
 		pr_info(
@@ -576,11 +781,197 @@ void zram_init_device(struct zram *zram, struct zram_meta *meta)
 	queue_flag_set_unlocked(QUEUE_FLAG_NONROT, zram->disk->queue);
 
 	zram->meta = meta;
+	zram->comp = comp;
 	zram->init_done = 1;
 
 	pr_debug("Initialization done!\n");
 }
 
+#ifdef CONFIG_ZRAM_WRITEBACK
+/*
+ * Mark all stored pages idle. Pages which are still idle the next time
+ * zram_writeback() runs were not accessed in between. Must be called
+ * with zram->init_lock held and the device initialized.
+ */
+void zram_mark_idle(struct zram *zram)
+{
+	struct zram_meta *meta = zram->meta;
+	size_t index;
+
+	for (index = 0; index < zram->disksize >> PAGE_SHIFT; index++) {
+		down_write(&zram->lock);
+		if (meta->table[index].handle &&
+		    !zram_test_flag(meta, index, ZRAM_WB))
+			zram_set_flag(meta, index, ZRAM_IDLE);
+		up_write(&zram->lock);
+	}
+}
+
+/*
+ * Allocate up to @nr contiguous blocks of the backing device, fewer if
+ * there is no such area. Returns the first block, or 0 if the device is
+ * full.
+ */
+static unsigned long zram_alloc_bdev_blocks(struct zram *zram,
+					    unsigned int *nr)
+{
+	unsigned long blk;
+
+	spin_lock(&zram->bitmap_lock);
+	for (; *nr; *nr /= 2) {
+		blk = bitmap_find_next_zero_area(zram->bitmap,
+						 zram->nr_blocks, 1, *nr, 0);
+		if (blk < zram->nr_blocks) {
+			bitmap_set(zram->bitmap, blk, *nr);
+			spin_unlock(&zram->bitmap_lock);
+			return blk;
+		}
+	}
+	spin_unlock(&zram->bitmap_lock);
+	return 0;
+}
+
+/*
+ * Pick the next page to write back, starting at *@index, and decompress
+ * it into @mem. Returns 0, or -ENOENT if there is none left.
+ */
+static int zram_wb_next(struct zram *zram, size_t *index, bool huge,
+			char *mem)
+{
+	struct zram_meta *meta = zram->meta;
+	size_t nr_pages = zram->disksize >> PAGE_SHIFT;
+	int ret;
+
+	for (; *index < nr_pages; (*index)++) {
+		down_write(&zram->lock);
+		if (!meta->table[*index].handle ||
+		    zram_test_flag(meta, *index, ZRAM_ZERO) ||
+		    zram_test_flag(meta, *index, ZRAM_WB) ||
+		    zram_test_flag(meta, *index, ZRAM_UNDER_WB) ||
+		    (huge && meta->table[*index].size != PAGE_SIZE) ||
+		    (!huge && !zram_test_flag(meta, *index, ZRAM_IDLE))) {
+			up_write(&zram->lock);
+			continue;
+		}
+
+		ret = zram_decompress_page(zram, mem, *index);
+		if (!ret)
+			zram_set_flag(meta, *index, ZRAM_UNDER_WB);
+		up_write(&zram->lock);
+		if (!ret) {
+			(*index)++;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/*
+ * Write idle pages (or, if @huge, pages which did not compress) to the
+ * backing device and free their memory. Pages are gathered into batches
+ * of up to ZRAM_WB_BATCH, which go to contiguous blocks in one bio. A
+ * page which is freed or overwritten while its batch is written just
+ * gives its block back. Must be called with zram->init_lock held and the
+ * device initialized.
+ */
+int zram_writeback(struct zram *zram, bool huge)
+{
+	struct zram_meta *meta = zram->meta;
+	struct page *pages[ZRAM_WB_BATCH];
+	size_t indices[ZRAM_WB_BATCH];
+	unsigned int nr_alloc = 0, nr, nr_free, nr_bio, i;
+	size_t index = 0;
+	unsigned long blk;
+	struct bio *bio;
+	int ret = 0;
+
+	if (!zram->bdev)
+		return -ENODEV;
+
+	for (; nr_alloc < ZRAM_WB_BATCH; nr_alloc++) {
+		pages[nr_alloc] = alloc_page(GFP_KERNEL);
+		if (!pages[nr_alloc])
+			break;
+	}
+	if (!nr_alloc)
+		return -ENOMEM;
+
+	bio = bio_alloc(GFP_KERNEL, nr_alloc);
+	if (!bio) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	while (1) {
+		nr = nr_alloc;
+		blk = zram_alloc_bdev_blocks(zram, &nr);
+		if (!blk) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		for (i = 0; i < nr; i++) {
+			if (zram_wb_next(zram, &index, huge,
+					 page_address(pages[i])))
+				break;
+			indices[i] = index - 1;
+		}
+		/* give back the blocks beyond the last page found */
+		for (nr_free = i; nr_free < nr; nr_free++)
+			zram_free_bdev_block(zram, blk + nr_free);
+		if (!i)
+			break;
+
+		bio_reset(bio);
+		bio->bi_sector = (sector_t)blk << SECTORS_PER_PAGE_SHIFT;
+		bio->bi_bdev = zram->bdev;
+		/* the queue limits may cut the batch short */
+		for (nr_bio = 0; nr_bio < i; nr_bio++)
+			if (bio_add_page(bio, pages[nr_bio], PAGE_SIZE, 0) !=
+			    PAGE_SIZE)
+				break;
+		if (nr_bio)
+			ret = submit_bio_wait(WRITE, bio);
+		else
+			ret = -EIO;
+
+		down_write(&zram->lock);
+		for (nr = 0; nr < i; nr++) {
+			size_t idx = indices[nr];
+
+			if (ret || nr >= nr_bio ||
+			    !zram_test_flag(meta, idx, ZRAM_UNDER_WB)) {
+				/*
+				 * failed, not in the bio, or freed or
+				 * overwritten meanwhile
+				 */
+				zram_clear_flag(meta, idx, ZRAM_UNDER_WB);
+				zram_free_bdev_block(zram, blk + nr);
+				continue;
+			}
+			zram_free_page(zram, idx);
+			meta->table[idx].handle = blk + nr;
+			zram_set_flag(meta, idx, ZRAM_WB);
+			zram->stats.pages_wb++;
+		}
+		up_write(&zram->lock);
+		if (ret)
+			break;
+
+		/* retry the pages which did not fit with the next batch */
+		if (nr_bio < i)
+			index = indices[nr_bio];
+	}
+
+	bio_put(bio);
+out:
+	while (nr_alloc)
+		__free_page(pages[--nr_alloc]);
+	return ret;
+}
+#endif
+
 static void zram_slot_free_notify(struct block_device *bdev,
 				unsigned long index)
 {
@@ -605,6 +996,11 @@ static int create_device(struct zram *zram, int device_id)
 	init_rwsem(&zram->lock);
 	init_rwsem(&zram->init_lock);
 	spin_lock_init(&zram->stat64_lock);
+#ifdef CONFIG_ZRAM_WRITEBACK
+	spin_lock_init(&zram->bitmap_lock);
+#endif
+	strlcpy(zram->compressor, default_compressor,
+		sizeof(zram->compressor));
 
 	zram->queue = blk_alloc_queue(GFP_KERNEL);
 	if (!zram->queue) {
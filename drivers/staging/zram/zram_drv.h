@@ -19,6 +19,7 @@
 #include <linux/mutex.h>
 
 #include "../zsmalloc/zsmalloc.h"
+#include "zcomp.h"
 
 /*
  * Some arbitrary value. This is just to catch
@@ -40,6 +41,9 @@ static const size_t max_zpage_size = PAGE_SIZE / 4 * 3;
  * always return failure.
  */
 
+/* Compression algorithm used unless set through sysfs before init */
+static const char default_compressor[] = "lzo";
+
 /*-- End of configurable params */
 
 #define SECTOR_SHIFT		9
@@ -51,10 +55,19 @@ static const size_t max_zpage_size = PAGE_SIZE / 4 * 3;
 #define ZRAM_SECTOR_PER_LOGICAL_BLOCK	\
 	(1 << (ZRAM_LOGICAL_BLOCK_SHIFT - SECTOR_SHIFT))
 
+/* Pages written back to the backing device in one bio */
+#define ZRAM_WB_BATCH		64
+
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO,
+	/* Page is on the backing device, handle is its block number */
+	ZRAM_WB,
+	/* Page was not accessed since it was marked idle */
+	ZRAM_IDLE,
+	/* Page is being written back */
+	ZRAM_UNDER_WB,
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -81,21 +94,26 @@ struct zram_stats {
 	u32 pages_stored;	/* no. of pages currently stored */
 	u32 good_compress;	/* % of pages with compression ratio<=50% */
 	u32 bad_compress;	/* % of pages with compression ratio>=75% */
+	u64 num_compr;		/* no. of pages compressed */
+	u64 compr_ns;		/* total time spent compressing them */
+	u64 num_decompr;	/* no. of pages decompressed */
+	u64 decompr_ns;		/* total time spent decompressing them */
+	u32 pages_wb;		/* no. of pages on the backing device */
 };
 
 struct zram_meta {
-	void *compress_workmem;
-	void *compress_buffer;
 	struct table *table;
 	struct zs_pool *mem_pool;
 };
 
 struct zram {
 	struct zram_meta *meta;
+	struct zcomp *comp;	/* compression streams, one per CPU */
 	spinlock_t stat64_lock;	/* protect 64-bit stats */
-	struct rw_semaphore lock; /* protect compression buffers, table,
-				   * 32bit stat counters against concurrent
-				   * notifications, reads and writes */
+	struct rw_semaphore lock; /* protect table, 32bit stat counters
+				   * against concurrent notifications,
+				   * reads and writes; compression itself
+				   * runs outside of it */
 	struct request_queue *queue;
 	struct gendisk *disk;
 	int init_done;
@@ -106,6 +124,15 @@ struct zram {
 	 * we can store in a disk.
 	 */
 	u64 disksize;	/* bytes */
+	char compressor[8];	/* algorithm used when the disk is set up */
+#ifdef CONFIG_ZRAM_WRITEBACK
+	/* Backing device, set up before the disk, and its block bitmap */
+	struct block_device *bdev;
+	char *backing_dev;
+	unsigned long nr_blocks;
+	unsigned long *bitmap;
+	spinlock_t bitmap_lock;
+#endif
 
 	struct zram_stats stats;
 };
@@ -119,6 +146,12 @@ extern struct attribute_group zram_disk_attr_group;
 extern void zram_reset_device(struct zram *zram);
 extern struct zram_meta *zram_meta_alloc(u64 disksize);
 extern void zram_meta_free(struct zram_meta *meta);
-extern void zram_init_device(struct zram *zram, struct zram_meta *meta);
+extern void zram_init_device(struct zram *zram, struct zram_meta *meta,
+			     struct zcomp *comp);
+#ifdef CONFIG_ZRAM_WRITEBACK
+extern int zram_set_backing_dev(struct zram *zram, const char *path);
+extern void zram_mark_idle(struct zram *zram);
+extern int zram_writeback(struct zram *zram, bool huge);
+#endif
 
 #endif
@@ -133,3 +133,9 @@ tal_stat_t tal_mmp_tx(unsigned char *buffer, int size)
 	return TAL_STAT_BAD_PARAM;
 }
 EXPORT_SYMBOL(tal_mmp_tx);
+
+int tal_mmp_irq_safe(void)
+{
+	return tal_mmp && (tal_mmp->flags & TAL_MMP_F_IRQ_SAFE);
+}
+EXPORT_SYMBOL(tal_mmp_irq_safe);
@@ -27,6 +27,9 @@ disclaimer.
 /* Defines */
 #define TAL_MAX_PHONE_LINES	32
 
+/* MMP callbacks may be invoked directly from the TDM interrupt handler */
+#define TAL_MMP_F_IRQ_SAFE	0x1
+
 /* Enumerators */
 typedef enum {
 	TAL_PCM_FORMAT_1BYTE = 1,
@@ -62,6 +65,7 @@ typedef struct {
 typedef struct {
 	void (*tal_mmp_rx_callback)(unsigned char *rx_buff, int size);
 	void (*tal_mmp_tx_callback)(unsigned char *tx_buff, int size);
+	unsigned int flags;
 } tal_mmp_ops_t;
 
 typedef struct {
@@ -85,6 +89,7 @@ int tal_control(int cmd, void *data);
 tal_stat_t tal_set_if(tal_if_t *interface);
 tal_stat_t tal_mmp_rx(unsigned char *buffer, int size);
 tal_stat_t tal_mmp_tx(unsigned char *buffer, int size);
+int tal_mmp_irq_safe(void);
 tal_stat_t tal_write(unsigned char *buffer, int size);
 
 #endif /* _TAL_H */
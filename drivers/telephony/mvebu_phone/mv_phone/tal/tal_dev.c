@@ -69,6 +69,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/wait.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
 
 #ifndef CONFIG_OF
 #include "spi/mvSpi.h"
@@ -79,15 +82,190 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define	TALDEV_NAME	"tal"
 
+/* tdm_if takes 1 to 4 base periods of 10 ms per interrupt */
+#define TAL_DEV_PERIOD_STEP	10
+#define TAL_DEV_PERIOD_MAX	(4 * TAL_DEV_PERIOD_STEP)
+
+static unsigned int sampling_period = 10;
+module_param(sampling_period, uint, 0644);
+MODULE_PARM_DESC(sampling_period, "PCM period per interrupt in ms: 10, 20, 30 or 40 (default 10)");
+
+static unsigned int ring_slots = TAL_DEV_RING_SLOTS;
+module_param(ring_slots, uint, 0644);
+MODULE_PARM_DESC(ring_slots, "Periods per mmap'd ring, rounded up to a power of 2 (default 16)");
+
 static DECLARE_WAIT_QUEUE_HEAD(tal_dev_wait);
 static DEFINE_SPINLOCK(tal_dev_lock);
 static unsigned char *rx_buff_p, *tx_buff_p;
 static size_t rx_buff_size, tx_buff_size;
 
+/* mmap'd PCM ring, active while userspace holds a mapping */
+static void *ring_buf;
+static tal_dev_ring_t *ring;		/* control page, read-only to userspace */
+static tal_dev_ring_app_t *ring_app;	/* indices written by userspace */
+static unsigned long ring_size;
+static atomic_t ring_users = ATOMIC_INIT(0);
+
+/*
+ * Geometry and driver-owned indices. The ISR only trusts these; the
+ * copies in the control page are for the application.
+ */
+static struct {
+	unsigned int slots;
+	unsigned int chan_size;
+	unsigned int total_lines;
+	unsigned int rx_offset;
+	unsigned int tx_offset;
+	unsigned int rx_head;
+	unsigned int tx_tail;
+} ring_priv;
+
+#define TAL_DEV_RING_APP_OFFSET		PAGE_SIZE
+#define TAL_DEV_RING_RX_OFFSET		(2 * PAGE_SIZE)
+
+static inline int tal_dev_ring_active(void)
+{
+	return atomic_read(&ring_users) > 0;
+}
+
+static inline unsigned char *tal_dev_ring_slot(unsigned int offset, int line, unsigned int idx)
+{
+	return (unsigned char *)ring_buf + offset +
+		(line * ring_priv.slots + (idx & (ring_priv.slots - 1))) * ring_priv.chan_size;
+}
+
+/* Periods between a driver and an application index, at most a ring */
+static inline unsigned int tal_dev_ring_used(unsigned int head, unsigned int tail)
+{
+	return min(head - tail, ring_priv.slots);
+}
+
+/* Called from the TDM ISR: copy one period of every line to the Rx ring */
+static void tal_dev_ring_rx(unsigned char *rx_buff, int size)
+{
+	unsigned int head = ring_priv.rx_head;
+	unsigned int tail = ACCESS_ONCE(ring_app->rx_tail);
+	unsigned int chan_size = ring_priv.chan_size;
+	int line;
+
+	if (tal_dev_ring_used(head, tail) == ring_priv.slots ||
+	    size < ring_priv.total_lines * chan_size) {
+		ring->rx_drop++;
+		return;
+	}
+
+	for (line = 0; line < ring_priv.total_lines; line++)
+		memcpy(tal_dev_ring_slot(ring_priv.rx_offset, line, head),
+		       rx_buff + line * chan_size, chan_size);
+
+	ring_priv.rx_head = head + 1;
+
+	/* Publish data before the index */
+	smp_wmb();
+	ACCESS_ONCE(ring->rx_head) = head + 1;
+}
+
+/* Called from the TDM ISR: fetch the next period of every line from the Tx ring */
+static void tal_dev_ring_tx(unsigned char *tx_buff, int size)
+{
+	unsigned int head = ACCESS_ONCE(ring_app->tx_head);
+	unsigned int tail = ring_priv.tx_tail;
+	unsigned int chan_size = ring_priv.chan_size;
+	int line;
+
+	if (!tal_dev_ring_used(head, tail) ||
+	    size < ring_priv.total_lines * chan_size) {
+		ring->tx_under++;
+		return;
+	}
+
+	/* Read the index before the data it covers */
+	smp_rmb();
+	for (line = 0; line < ring_priv.total_lines; line++)
+		memcpy(tx_buff + line * chan_size,
+		       tal_dev_ring_slot(ring_priv.tx_offset, line, tail), chan_size);
+
+	ring_priv.tx_tail = tail + 1;
+
+	/* Done with the slot before handing it back */
+	smp_mb();
+	ACCESS_ONCE(ring->tx_tail) = tail + 1;
+}
+
+static void tal_dev_ring_reset(void)
+{
+	if (!ring)
+		return;
+
+	ring_priv.rx_head = ring_priv.tx_tail = 0;
+	ring->rx_head = ring->tx_tail = 0;
+	ring->rx_drop = ring->tx_under = 0;
+	ring_app->rx_tail = ring_app->tx_head = 0;
+}
+
+static int tal_dev_ring_alloc(tal_params_t *params)
+{
+	unsigned int chan_size, area, slots;
+	unsigned long size;
+
+	slots = roundup_pow_of_two(clamp(ring_slots, 2U, 256U));
+
+	/* 8 samples per ms per line */
+	chan_size = params->pcm_format * 8 * params->sampling_period;
+	area = params->total_lines * slots * chan_size;
+	size = PAGE_ALIGN(TAL_DEV_RING_RX_OFFSET + 2 * area);
+
+	if (ring && ring_size == size && ring_priv.chan_size == chan_size &&
+	    ring_priv.slots == slots &&
+	    ring_priv.total_lines == params->total_lines) {
+		tal_dev_ring_reset();
+		return 0;
+	}
+
+	/* Geometry changed under an existing mapping */
+	if (tal_dev_ring_active())
+		return -EBUSY;
+
+	vfree(ring_buf);
+	ring = NULL;
+	ring_app = NULL;
+	ring_buf = vmalloc_user(size);
+	if (!ring_buf) {
+		ring_size = 0;
+		return -ENOMEM;
+	}
+
+	ring_size = size;
+	ring = ring_buf;
+	ring_app = ring_buf + TAL_DEV_RING_APP_OFFSET;
+
+	ring_priv.slots = slots;
+	ring_priv.chan_size = chan_size;
+	ring_priv.total_lines = params->total_lines;
+	ring_priv.rx_offset = TAL_DEV_RING_RX_OFFSET;
+	ring_priv.tx_offset = TAL_DEV_RING_RX_OFFSET + area;
+	ring_priv.rx_head = ring_priv.tx_tail = 0;
+
+	ring->slots = slots;
+	ring->chan_size = chan_size;
+	ring->total_lines = params->total_lines;
+	ring->app_offset = TAL_DEV_RING_APP_OFFSET;
+	ring->rx_offset = ring_priv.rx_offset;
+	ring->tx_offset = ring_priv.tx_offset;
+
+	return 0;
+}
+
 static void tal_dev_rx_callback(unsigned char *rx_buff, int size)
 {
 	unsigned long flags;
 
+	if (tal_dev_ring_active()) {
+		tal_dev_ring_rx(rx_buff, size);
+		wake_up_interruptible(&tal_dev_wait);
+		return;
+	}
+
 	/* Save buffer */
 	spin_lock_irqsave(&tal_dev_lock, flags);
 	rx_buff_p = rx_buff;
@@ -101,6 +279,12 @@ static void tal_dev_tx_callback(unsigned char *tx_buff, int size)
 {
 	unsigned long flags;
 
+	if (tal_dev_ring_active()) {
+		tal_dev_ring_tx(tx_buff, size);
+		wake_up_interruptible(&tal_dev_wait);
+		return;
+	}
+
 	/* Save buffer */
 	spin_lock_irqsave(&tal_dev_lock, flags);
 	tx_buff_p = tx_buff;
@@ -114,6 +298,7 @@ static tal_params_t tal_params;
 static tal_mmp_ops_t tal_mmp_ops = {
 	.tal_mmp_rx_callback	= tal_dev_rx_callback,
 	.tal_mmp_tx_callback	= tal_dev_tx_callback,
+	.flags			= TAL_MMP_F_IRQ_SAFE,
 };
 
 static ssize_t tal_dev_read(struct file *file_p, char __user *buf, size_t size, loff_t *ppos)
@@ -183,6 +368,16 @@ static unsigned int tal_dev_poll(struct file *file_p, poll_table *poll_table_p)
 
 	poll_wait(file_p, &tal_dev_wait, poll_table_p);
 
+	if (tal_dev_ring_active()) {
+		if (tal_dev_ring_used(ACCESS_ONCE(ring_priv.rx_head),
+				      ACCESS_ONCE(ring_app->rx_tail)))
+			mask |= POLLIN | POLLRDNORM;
+		if (tal_dev_ring_used(ACCESS_ONCE(ring_app->tx_head),
+				      ACCESS_ONCE(ring_priv.tx_tail)) < ring_priv.slots)
+			mask |= POLLOUT | POLLWRNORM;
+		return mask;
+	}
+
 	spin_lock_irqsave(&tal_dev_lock, flags);
 	if (rx_buff_p)
 		mask |= POLLIN | POLLRDNORM;
@@ -223,12 +418,24 @@ static long tal_dev_ioctl(struct file *file_p, unsigned int cmd,
 		if (copy_from_user(&tal_dev_params, (void *)arg, sizeof(tal_dev_params)))
 			return -EFAULT;
 
+		/* tal_params_t holds the period in a byte */
+		if (!sampling_period || sampling_period > TAL_DEV_PERIOD_MAX ||
+		    sampling_period % TAL_DEV_PERIOD_STEP) {
+			pr_err("%s: invalid sampling_period %u ms\n", __func__,
+			       sampling_period);
+			return -EINVAL;
+		}
+
 		tal_params.pcm_format = tal_dev_params.pcm_format;
-		tal_params.sampling_period = 10; /* ms */
+		tal_params.sampling_period = sampling_period; /* ms */
 		tal_params.total_lines = tal_dev_params.total_lines;
 		for (i = 0; i < TAL_MAX_PHONE_LINES; i++)
 			tal_params.pcm_slot[i] = (i + 1) * tal_dev_params.pcm_format;
 
+		ret = tal_dev_ring_alloc(&tal_params);
+		if (ret)
+			return ret;
+
 		if (tal_init(&tal_params, &tal_mmp_ops) != TAL_STAT_OK)
 			return -EIO;
 
@@ -241,6 +448,7 @@ static long tal_dev_ioctl(struct file *file_p, unsigned int cmd,
 	case TAL_DEV_PCM_START:
 		rx_buff_p = NULL;
 		tx_buff_p = NULL;
+		tal_dev_ring_reset();
 		tal_pcm_start();
 		break;
 
@@ -269,11 +477,56 @@ static long tal_dev_ioctl(struct file *file_p, unsigned int cmd,
 	return ret;
 }
 
+static void tal_dev_vm_open(struct vm_area_struct *vma)
+{
+	atomic_inc(&ring_users);
+}
+
+static void tal_dev_vm_close(struct vm_area_struct *vma)
+{
+	atomic_dec(&ring_users);
+}
+
+static const struct vm_operations_struct tal_dev_vm_ops = {
+	.open	= tal_dev_vm_open,
+	.close	= tal_dev_vm_close,
+};
+
+static int tal_dev_mmap(struct file *file_p, struct vm_area_struct *vma)
+{
+	unsigned long pages = ring_size >> PAGE_SHIFT;
+	int ret;
+
+	/* The ring is sized by TAL_DEV_INIT */
+	if (!ring)
+		return -ENODEV;
+
+	if (vma->vm_pgoff >= pages || vma_pages(vma) > pages - vma->vm_pgoff)
+		return -EINVAL;
+
+	/* The control page is only written by the driver */
+	if (vma->vm_pgoff == 0) {
+		if (vma->vm_flags & VM_WRITE)
+			return -EPERM;
+		vma->vm_flags &= ~VM_MAYWRITE;
+	}
+
+	ret = remap_vmalloc_range(vma, ring_buf, vma->vm_pgoff);
+	if (ret)
+		return ret;
+
+	vma->vm_ops = &tal_dev_vm_ops;
+	tal_dev_vm_open(vma);
+
+	return 0;
+}
+
 static const struct file_operations tal_dev_fops = {
 	.owner		= THIS_MODULE,
 	.read		= tal_dev_read,
 	.write		= tal_dev_write,
 	.poll		= tal_dev_poll,
+	.mmap		= tal_dev_mmap,
 	.unlocked_ioctl	= tal_dev_ioctl,
 	.open		= tal_dev_open,
 	.release	= tal_dev_release,
@@ -301,6 +554,7 @@ static int __init tal_dev_init(void)
 static void __exit tal_dev_exit(void)
 {
 	misc_deregister(&tal_dev);
+	vfree(ring_buf);
 }
 
 /* Module stuff */
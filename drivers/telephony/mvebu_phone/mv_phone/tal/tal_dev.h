@@ -77,6 +77,47 @@ typedef struct {
 	unsigned short total_lines;
 } tal_dev_params_t;
 
+/*
+ * PCM ring shared with userspace through mmap() of the TAL device.
+ * The mapping starts with the control page (tal_dev_ring_t), which is
+ * written by the driver only and can only be mapped read-only.  It is
+ * followed by the application page (tal_dev_ring_app_t) at app_offset
+ * and the Rx and Tx areas at rx_offset/tx_offset, which are mapped
+ * from a non-zero offset when they have to be writable.  Each area
+ * holds one ring per line of 'slots' periods of chan_size bytes;
+ * period n of line l lives at
+ * offset + (l * slots + (n & (slots - 1))) * chan_size, where chan_size
+ * covers one interrupt period (sampling_period module parameter).  All lines
+ * advance together, so a single pair of indices serves every ring.
+ * Indices are free running; a ring is empty when head == tail.
+ * The driver only writes rx_head/tx_tail and the counters, the
+ * application only writes rx_tail/tx_head; an application index more
+ * than 'slots' away from the driver's is clamped.  Indices are reset on
+ * TAL_DEV_PCM_START.
+ */
+#define TAL_DEV_RING_SLOTS		16	/* default, see ring_slots module parameter */
+
+typedef struct {
+	/* Written by the driver */
+	unsigned int rx_head;
+	unsigned int tx_tail;
+	unsigned int rx_drop;
+	unsigned int tx_under;
+	/* Layout, fixed by TAL_DEV_INIT */
+	unsigned int slots;
+	unsigned int chan_size;
+	unsigned int total_lines;
+	unsigned int app_offset;
+	unsigned int rx_offset;
+	unsigned int tx_offset;
+} tal_dev_ring_t;
+
+typedef struct {
+	/* Written by the application */
+	unsigned int rx_tail;
+	unsigned int tx_head;
+} tal_dev_ring_app_t;
+
 /* TDM-specific ioctls exported to TAL by tdm_if */
 #if defined(MV_TDM_USE_DCO)
 typedef struct tdm_dev_clk {
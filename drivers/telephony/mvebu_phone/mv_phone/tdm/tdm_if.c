@@ -68,6 +68,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <linux/module.h>
 #include <linux/init.h>
 #include <linux/proc_fs.h>
+#include <linux/ktime.h>
 #include <plat/drv_dxt_if.h>
 #include <plat/zarlink_if.h>
 #include <plat/silabs_if.h>
@@ -78,6 +79,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define TDM_STOP_MAX_POLLING_TIME 20 /* ms */
 
+/* Longest period the PCM buffers may be coalesced to, in base periods */
+#define TDM_MAX_PERIOD_FACTOR	4
+
+/* Interrupt jitter histogram: bucket n counts deviations below 125us << n */
+#define TDM_JITTER_BUCKETS	8
+#define TDM_JITTER_BASE_US	125
+
 /* TDM Interrupt Service Routine */
 static irqreturn_t tdm_if_isr(int irq, void* dev_id);
 
@@ -85,13 +93,14 @@ static irqreturn_t tdm_if_isr(int irq, void* dev_id);
 static void tdm_if_pcm_start(void);
 static void tdm_if_pcm_stop(void);
 
+/* Rx/Tx processing */
+static void tdm_if_pcm_rx_process(void);
+static void tdm_if_pcm_tx_process(void);
+
 /* Rx/Tx Tasklets  */
 #if !(defined CONFIG_MV_PHONE_USE_IRQ_PROCESSING) && !(defined CONFIG_MV_PHONE_USE_FIQ_PROCESSING)
-static void tdm_if_pcm_rx_process(unsigned long arg);
-static void tdm_if_pcm_tx_process(unsigned long arg);
-#else
-static inline void tdm_if_pcm_rx_process(void);
-static inline void tdm_if_pcm_tx_process(void);
+static void tdm_if_pcm_rx_tasklet(unsigned long arg);
+static void tdm_if_pcm_tx_tasklet(unsigned long arg);
 #endif
 /* TDM proc-fs statistics */
 #ifndef CONFIG_OF
@@ -120,8 +129,8 @@ static void __exit tdm_if_module_exit(void);
 
 /* Globals */
 #if !(defined CONFIG_MV_PHONE_USE_IRQ_PROCESSING) && !(defined CONFIG_MV_PHONE_USE_FIQ_PROCESSING)
-static DECLARE_TASKLET(tdm_if_rx_tasklet, tdm_if_pcm_rx_process, 0);
-static DECLARE_TASKLET(tdm_if_tx_tasklet, tdm_if_pcm_tx_process, 0);
+static DECLARE_TASKLET(tdm_if_rx_tasklet, tdm_if_pcm_rx_tasklet, 0);
+static DECLARE_TASKLET(tdm_if_tx_tasklet, tdm_if_pcm_tx_tasklet, 0);
 #endif
 static DECLARE_TASKLET(tdm2c_if_stop_tasklet, tdm2c_if_stop_channels, 0);
 static DEFINE_SPINLOCK(tdm_if_lock);
@@ -143,10 +152,36 @@ static int pcm_stop_status;
 static unsigned int pcm_start_stop_state;
 static unsigned int is_pcm_stopping;
 static unsigned int mv_tdm_unit_type;
+static unsigned int sampling_period;
+static ktime_t rx_last, tx_last;
+static unsigned int rx_jitter[TDM_JITTER_BUCKETS], tx_jitter[TDM_JITTER_BUCKETS];
+static const char * const tdm_jitter_names[TDM_JITTER_BUCKETS] = {
+	"<125us", "<250us", "<500us", "<1ms", "<2ms", "<4ms", "<8ms", ">=8ms"
+};
+
+/* Account the deviation of this interrupt from the nominal PCM period */
+static void tdm_if_jitter_account(ktime_t *last, unsigned int *hist)
+{
+	ktime_t now = ktime_get();
+	s64 dev;
+	int bucket;
+
+	if (last->tv64) {
+		dev = ktime_us_delta(now, *last) - sampling_period * USEC_PER_MSEC;
+		if (dev < 0)
+			dev = -dev;
+		bucket = dev < TDM_JITTER_BASE_US ? 0 : fls((u32)div_s64(dev, TDM_JITTER_BASE_US));
+		if (bucket >= TDM_JITTER_BUCKETS)
+			bucket = TDM_JITTER_BUCKETS - 1;
+		hist[bucket]++;
+	}
+	*last = now;
+}
 
 #ifdef CONFIG_OF
 static int proc_tdm_status_show(struct seq_file *m, void *v)
 {
+	int i;
 #ifdef CONFIG_MV_TDM_EXT_STATS
 	MV_TDM_EXTENDED_STATS tdm_ext_stats;
 #endif
@@ -157,6 +192,11 @@ static int proc_tdm_status_show(struct seq_file *m, void *v)
 	seq_printf(m, "rx_over:		%u\n", rx_over);
 	seq_printf(m, "tx_under:	%u\n", tx_under);
 
+	seq_printf(m, "\nIRQ jitter (period %u ms):\n", sampling_period);
+	for (i = 0; i < TDM_JITTER_BUCKETS; i++)
+		seq_printf(m, "%-8s	rx %u	tx %u\n", tdm_jitter_names[i],
+			   rx_jitter[i], tx_jitter[i]);
+
 #ifdef CONFIG_MV_TDM_EXT_STATS
 	mvTdmExtStatsGet(&tdm_ext_stats);
 
@@ -249,6 +289,7 @@ static int proc_dump_ext_stats(char *buffer, char **buffer_location, off_t offse
 {
 	char *str;
 	MV_TDM_EXTENDED_STATS tdm_ext_stats;
+	int i;
 
 	if (offset > 0)
 		return 0;
@@ -270,6 +311,11 @@ static int proc_dump_ext_stats(char *buffer, char **buffer_location, off_t offse
 	str += sprintf(str, "pcmRestartCount = %u\n", tdm_ext_stats.pcmRestartCount);
 	str += sprintf(str, "pcm_stop_fail = %u\n", pcm_stop_fail);
 
+	str += sprintf(str, "\nIRQ jitter (period %u ms):\n", sampling_period);
+	for (i = 0; i < TDM_JITTER_BUCKETS; i++)
+		str += sprintf(str, "%-8s rx %u tx %u\n", tdm_jitter_names[i],
+			       rx_jitter[i], tx_jitter[i]);
+
 	return (int)(str - buffer);
 }
 #endif
@@ -324,6 +370,21 @@ MV_STATUS tdm_if_init(tal_params_t *tal_params)
 	pcm_stop_fail = 0;
 #endif
 
+	/*
+	 * Several base periods may be coalesced into one interrupt; the
+	 * buffers grow accordingly and the IRQ rate drops by the same factor.
+	 */
+	if (!tal_params->sampling_period ||
+	    tal_params->sampling_period % MV_TDM_BASE_SAMPLING_PERIOD ||
+	    tal_params->sampling_period > TDM_MAX_PERIOD_FACTOR * MV_TDM_BASE_SAMPLING_PERIOD) {
+		printk(KERN_ERR "%s: unsupported sampling period %u ms\n", __func__,
+		       tal_params->sampling_period);
+		return MV_ERROR;
+	}
+	sampling_period = tal_params->sampling_period;
+	memset(rx_jitter, 0, sizeof(rx_jitter));
+	memset(tx_jitter, 0, sizeof(tx_jitter));
+
 	/* Calculate Rx/Tx buffer size(use in callbacks) */
 	buff_size = (tal_params->pcm_format * tal_params->total_lines * 80 *
 			(tal_params->sampling_period/MV_TDM_BASE_SAMPLING_PERIOD));
@@ -477,6 +538,8 @@ static void tdm_if_pcm_start(void)
 	spin_lock_irqsave(&tdm_if_lock, flags);
 	if (!pcm_enable) {
 		pcm_enable = 1;
+		rx_last.tv64 = 0;
+		tx_last.tv64 = 0;
 #ifdef CONFIG_MV_TDM2C_SUPPORT
 		if (MV_TDM_UNIT_TDM2C == tdm_if_unit_type_get()) {
 			if (is_pcm_stopping == 0) {
@@ -614,6 +677,7 @@ static irqreturn_t tdm_if_isr(int irq, void* dev_id)
 	/* Support multiple interrupt handling */
 	/* RX interrupt */
 	if (int_type & MV_RX_INT) {
+		tdm_if_jitter_account(&rx_last, rx_jitter);
 		if (rxBuff != NULL) {
 			rx_miss++;
 			TRC_REC("%s: Warning, missed Rx buffer processing !!!\n", __func__);
@@ -623,15 +687,22 @@ static irqreturn_t tdm_if_isr(int irq, void* dev_id)
 			TRC_REC("%s: running Rx in ISR\n", __func__);
 			tdm_if_pcm_rx_process();
 #else
-			/* Schedule Rx processing within SOFT_IRQ context */
-			TRC_REC("%s: schedule Rx tasklet\n", __func__);
-			tasklet_hi_schedule(&tdm_if_rx_tasklet);
+			if (tal_mmp_irq_safe()) {
+				/* MMP only copies to its ring, no need to defer */
+				TRC_REC("%s: running Rx in ISR\n", __func__);
+				tdm_if_pcm_rx_process();
+			} else {
+				/* Schedule Rx processing within SOFT_IRQ context */
+				TRC_REC("%s: schedule Rx tasklet\n", __func__);
+				tasklet_hi_schedule(&tdm_if_rx_tasklet);
+			}
 #endif
 		}
 	}
 
 	/* TX interrupt */
 	if (int_type & MV_TX_INT) {
+		tdm_if_jitter_account(&tx_last, tx_jitter);
 		if (txBuff != NULL) {
 			tx_miss++;
 			TRC_REC("%s: Warning, missed Tx buffer processing !!!\n", __func__);
@@ -641,9 +712,14 @@ static irqreturn_t tdm_if_isr(int irq, void* dev_id)
 			TRC_REC("%s: running Tx in ISR\n", __func__);
 			tdm_if_pcm_tx_process();
 #else
-			/* Schedule Tx processing within SOFT_IRQ context */
-			TRC_REC("%s: schedule Tx tasklet\n", __func__);
-			tasklet_hi_schedule(&tdm_if_tx_tasklet);
+			if (tal_mmp_irq_safe()) {
+				TRC_REC("%s: running Tx in ISR\n", __func__);
+				tdm_if_pcm_tx_process();
+			} else {
+				/* Schedule Tx processing within SOFT_IRQ context */
+				TRC_REC("%s: schedule Tx tasklet\n", __func__);
+				tasklet_hi_schedule(&tdm_if_tx_tasklet);
+			}
 #endif
 		}
 	}
@@ -684,12 +760,7 @@ out:
 	TRC_REC("<-%s\n", __func__);
 	return IRQ_HANDLED;
 }
-#if (defined CONFIG_MV_PHONE_USE_IRQ_PROCESSING) || (defined CONFIG_MV_PHONE_USE_FIQ_PROCESSING)
-static inline void tdm_if_pcm_rx_process(void)
-#else
-/* Rx tasklet */
-static void tdm_if_pcm_rx_process(unsigned long arg)
-#endif
+static void tdm_if_pcm_rx_process(void)
 {
 	unsigned long flags;
 	unsigned int tdm_type;
@@ -747,12 +818,7 @@ static void tdm_if_pcm_rx_process(unsigned long arg)
 	return;
 }
 
-#if (defined CONFIG_MV_PHONE_USE_IRQ_PROCESSING) || (defined CONFIG_MV_PHONE_USE_FIQ_PROCESSING)
-static inline void tdm_if_pcm_tx_process(void)
-#else
-/* Tx tasklet */
-static void tdm_if_pcm_tx_process(unsigned long arg)
-#endif
+static void tdm_if_pcm_tx_process(void)
 {
 	unsigned long flags;
 	unsigned int tdm_type;
@@ -808,6 +874,20 @@ static void tdm_if_pcm_tx_process(unsigned long arg)
 	return;
 }
 
+#if !(defined CONFIG_MV_PHONE_USE_IRQ_PROCESSING) && !(defined CONFIG_MV_PHONE_USE_FIQ_PROCESSING)
+/* Rx tasklet */
+static void tdm_if_pcm_rx_tasklet(unsigned long arg)
+{
+	tdm_if_pcm_rx_process();
+}
+
+/* Tx tasklet */
+static void tdm_if_pcm_tx_tasklet(unsigned long arg)
+{
+	tdm_if_pcm_tx_process();
+}
+#endif
+
 void tdm_if_stats_get(tal_stats_t *tdm_if_stats)
 {
 	if (tdm_init == 0)
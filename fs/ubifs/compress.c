@@ -25,9 +25,17 @@
 /*
  * This file provides a single place to access to compression and
  * decompression.
+ *
+ * Every compressor owns a pool of cryptoapi handles, one per possible CPU,
+ * so that writeback and readpage running on different CPUs do not serialize
+ * on a single handle. A task takes an idle handle from the pool, and only
+ * sleeps if all of them are busy.
  */
 
 #include <linux/crypto.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+#include <linux/workqueue.h>
 #include "ubifs.h"
 
 /* Fake description object for the "none" compressor */
@@ -38,11 +46,8 @@ static struct ubifs_compressor none_compr = {
 };
 
 #ifdef CONFIG_UBIFS_FS_LZO
-static DEFINE_MUTEX(lzo_mutex);
-
 static struct ubifs_compressor lzo_compr = {
 	.compr_type = UBIFS_COMPR_LZO,
-	.comp_mutex = &lzo_mutex,
 	.name = "lzo",
 	.capi_name = "lzo",
 };
@@ -54,13 +59,8 @@ static struct ubifs_compressor lzo_compr = {
 #endif
 
 #ifdef CONFIG_UBIFS_FS_ZLIB
-static DEFINE_MUTEX(deflate_mutex);
-static DEFINE_MUTEX(inflate_mutex);
-
 static struct ubifs_compressor zlib_compr = {
 	.compr_type = UBIFS_COMPR_ZLIB,
-	.comp_mutex = &deflate_mutex,
-	.decomp_mutex = &inflate_mutex,
 	.name = "zlib",
 	.capi_name = "deflate",
 };
@@ -71,9 +71,69 @@ static struct ubifs_compressor zlib_compr = {
 };
 #endif
 
+/* Placeholder for a type other implementations use, never compiled in */
+static struct ubifs_compressor zstd_compr = {
+	.compr_type = UBIFS_COMPR_ZSTD,
+	.name = "zstd",
+};
+
+#ifdef CONFIG_UBIFS_FS_LZ4
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+	.capi_name = "lz4",
+};
+#else
+static struct ubifs_compressor lz4_compr = {
+	.compr_type = UBIFS_COMPR_LZ4,
+	.name = "lz4",
+};
+#endif
+
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
+/* Workqueue compressing pages ahead of the journal during write-back */
+struct workqueue_struct *ubifs_compr_wq;
+
+/**
+ * get_ctx - get an idle compression context.
+ * @compr: compressor description object
+ *
+ * This function takes a context out of the pool of @compr, waiting for one
+ * to be released if all of them are in use.
+ */
+static struct ubifs_compr_ctx *get_ctx(struct ubifs_compressor *compr)
+{
+	struct ubifs_compr_ctx *ctx;
+
+	spin_lock(&compr->ctx_lock);
+	while (list_empty(&compr->idle_ctx)) {
+		spin_unlock(&compr->ctx_lock);
+		atomic64_inc(&compr->stats.ctx_waits);
+		wait_event(compr->ctx_wait, !list_empty(&compr->idle_ctx));
+		spin_lock(&compr->ctx_lock);
+	}
+	ctx = list_first_entry(&compr->idle_ctx, struct ubifs_compr_ctx, list);
+	list_del(&ctx->list);
+	spin_unlock(&compr->ctx_lock);
+
+	return ctx;
+}
+
+/**
+ * put_ctx - return a compression context to the pool.
+ * @compr: compressor description object
+ * @ctx: the context to return
+ */
+static void put_ctx(struct ubifs_compressor *compr, struct ubifs_compr_ctx *ctx)
+{
+	spin_lock(&compr->ctx_lock);
+	list_add(&ctx->list, &compr->idle_ctx);
+	spin_unlock(&compr->ctx_lock);
+	wake_up(&compr->ctx_wait);
+}
+
 /**
  * ubifs_compress - compress data.
  * @in_buf: data to compress
@@ -97,6 +157,8 @@ void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 {
 	int err;
 	struct ubifs_compressor *compr = ubifs_compressors[*compr_type];
+	struct ubifs_compr_ctx *ctx;
+	ktime_t start;
 
 	if (*compr_type == UBIFS_COMPR_NONE)
 		goto no_compr;
@@ -105,17 +167,22 @@ void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 	if (in_len < UBIFS_MIN_COMPR_LEN)
 		goto no_compr;
 
-	if (compr->comp_mutex)
-		mutex_lock(compr->comp_mutex);
-	err = crypto_comp_compress(compr->cc, in_buf, in_len, out_buf,
+	ctx = get_ctx(compr);
+	start = ktime_get();
+	err = crypto_comp_compress(ctx->cc, in_buf, in_len, out_buf,
 				   (unsigned int *)out_len);
-	if (compr->comp_mutex)
-		mutex_unlock(compr->comp_mutex);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), start)),
+		     &compr->stats.comp_ns);
+	put_ctx(compr, ctx);
+
+	atomic64_inc(&compr->stats.comp_cnt);
+	atomic64_add(in_len, &compr->stats.comp_in);
 	if (unlikely(err)) {
 		ubifs_warn("cannot compress %d bytes, compressor %s, error %d, leave data uncompressed",
 			   in_len, compr->name, err);
 		 goto no_compr;
 	}
+	atomic64_add(*out_len, &compr->stats.comp_out);
 
 	/*
 	 * If the data compressed only slightly, it is better to leave it
@@ -149,6 +216,8 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 {
 	int err;
 	struct ubifs_compressor *compr;
+	struct ubifs_compr_ctx *ctx;
+	ktime_t start;
 
 	if (unlikely(compr_type < 0 || compr_type >= UBIFS_COMPR_TYPES_CNT)) {
 		ubifs_err("invalid compression type %d", compr_type);
@@ -168,17 +237,23 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
 		return 0;
 	}
 
-	if (compr->decomp_mutex)
-		mutex_lock(compr->decomp_mutex);
-	err = crypto_comp_decompress(compr->cc, in_buf, in_len, out_buf,
+	ctx = get_ctx(compr);
+	start = ktime_get();
+	err = crypto_comp_decompress(ctx->cc, in_buf, in_len, out_buf,
 				     (unsigned int *)out_len);
-	if (compr->decomp_mutex)
-		mutex_unlock(compr->decomp_mutex);
-	if (err)
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), start)),
+		     &compr->stats.decomp_ns);
+	put_ctx(compr, ctx);
+	if (err) {
 		ubifs_err("cannot decompress %d bytes, compressor %s, error %d",
 			  in_len, compr->name, err);
+		return err;
+	}
 
-	return err;
+	atomic64_inc(&compr->stats.decomp_cnt);
+	atomic64_add(in_len, &compr->stats.decomp_in);
+	atomic64_add(*out_len, &compr->stats.decomp_out);
+	return 0;
 }
 
 /**
@@ -190,17 +265,43 @@ int ubifs_decompress(const void *in_buf, int in_len, void *out_buf,
  */
 static int __init compr_init(struct ubifs_compressor *compr)
 {
+	int i, err;
+
+	INIT_LIST_HEAD(&compr->idle_ctx);
+	spin_lock_init(&compr->ctx_lock);
+	init_waitqueue_head(&compr->ctx_wait);
+
 	if (compr->capi_name) {
-		compr->cc = crypto_alloc_comp(compr->capi_name, 0, 0);
-		if (IS_ERR(compr->cc)) {
-			ubifs_err("cannot initialize compressor %s, error %ld",
-				  compr->name, PTR_ERR(compr->cc));
-			return PTR_ERR(compr->cc);
+		compr->ctx = kcalloc(num_possible_cpus(), sizeof(*compr->ctx),
+				     GFP_KERNEL);
+		if (!compr->ctx)
+			return -ENOMEM;
+
+		for (i = 0; i < num_possible_cpus(); i++) {
+			struct ubifs_compr_ctx *ctx = &compr->ctx[i];
+
+			ctx->cc = crypto_alloc_comp(compr->capi_name, 0, 0);
+			if (IS_ERR(ctx->cc)) {
+				err = PTR_ERR(ctx->cc);
+				ubifs_err("cannot initialize compressor %s, error %d",
+					  compr->name, err);
+				goto out_free;
+			}
+			list_add_tail(&ctx->list, &compr->idle_ctx);
+			compr->ctx_cnt += 1;
 		}
 	}
 
 	ubifs_compressors[compr->compr_type] = compr;
 	return 0;
+
+out_free:
+	for (i = 0; i < compr->ctx_cnt; i++)
+		crypto_free_comp(compr->ctx[i].cc);
+	kfree(compr->ctx);
+	compr->ctx = NULL;
+	compr->ctx_cnt = 0;
+	return err;
 }
 
 /**
@@ -209,8 +310,11 @@ static int __init compr_init(struct ubifs_compressor *compr)
  */
 static void compr_exit(struct ubifs_compressor *compr)
 {
-	if (compr->capi_name)
-		crypto_free_comp(compr->cc);
+	int i;
+
+	for (i = 0; i < compr->ctx_cnt; i++)
+		crypto_free_comp(compr->ctx[i].cc);
+	kfree(compr->ctx);
 	return;
 }
 
@@ -232,9 +336,28 @@ int __init ubifs_compressors_init(void)
 	if (err)
 		goto out_lzo;
 
+	err = compr_init(&zstd_compr);
+	if (err)
+		goto out_zlib;
+
+	err = compr_init(&lz4_compr);
+	if (err)
+		goto out_zlib;
+
+	ubifs_compr_wq = alloc_workqueue("ubifs_compr",
+					 WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!ubifs_compr_wq) {
+		err = -ENOMEM;
+		goto out_lz4;
+	}
+
 	ubifs_compressors[UBIFS_COMPR_NONE] = &none_compr;
 	return 0;
 
+out_lz4:
+	compr_exit(&lz4_compr);
+out_zlib:
+	compr_exit(&zlib_compr);
 out_lzo:
 	compr_exit(&lzo_compr);
 	return err;
@@ -245,6 +368,81 @@ out_lzo:
  */
 void ubifs_compressors_exit(void)
 {
+	destroy_workqueue(ubifs_compr_wq);
 	compr_exit(&lzo_compr);
 	compr_exit(&zlib_compr);
+	compr_exit(&lz4_compr);
+}
+
+/**
+ * ubifs_compr_lookup - find compressor type by its name.
+ * @name: compressor name, not necessarily zero-terminated
+ * @len: length of @name
+ *
+ * Returns the compressor type (%UBIFS_COMPR_LZO, etc) or %-EINVAL if there
+ * is no compressor called @name. The compressor is not necessarily compiled
+ * in, see 'ubifs_compr_present()'.
+ */
+int ubifs_compr_lookup(const char *name, int len)
+{
+	int i;
+
+	for (i = 0; i < UBIFS_COMPR_TYPES_CNT; i++) {
+		const char *n = ubifs_compressors[i]->name;
+
+		if (strlen(n) == len && !memcmp(n, name, len))
+			return i;
+	}
+	return -EINVAL;
+}
+
+/**
+ * compr_rate - compute throughput in KiB/s.
+ * @bytes: amount of data processed
+ * @ns: time it took, in nanoseconds
+ */
+static unsigned long long compr_rate(u64 bytes, u64 ns)
+{
+	if (!ns)
+		return 0;
+	return div64_u64(bytes * (NSEC_PER_SEC >> 10), ns);
+}
+
+/**
+ * ubifs_compr_dump_stats - print compressor throughput counters.
+ * @m: the seq_file to print to
+ *
+ * This is used by the "compr_stats" debugfs file. Throughput is computed
+ * over the uncompressed size, for both directions.
+ */
+void ubifs_compr_dump_stats(struct seq_file *m)
+{
+	int i;
+
+	for (i = 0; i < UBIFS_COMPR_TYPES_CNT; i++) {
+		struct ubifs_compressor *compr = ubifs_compressors[i];
+		struct ubifs_compr_stats *st;
+		u64 in, out, ns;
+
+		if (!compr || !compr->ctx_cnt)
+			continue;
+		st = &compr->stats;
+
+		seq_printf(m, "%s: contexts %d, waits %lld\n", compr->name,
+			   compr->ctx_cnt, atomic64_read(&st->ctx_waits));
+
+		in = atomic64_read(&st->comp_in);
+		out = atomic64_read(&st->comp_out);
+		ns = atomic64_read(&st->comp_ns);
+		seq_printf(m, "\tcompress:   %lld calls, %llu -> %llu bytes, %llu us, %llu KiB/s\n",
+			   atomic64_read(&st->comp_cnt), in, out,
+			   div_u64(ns, NSEC_PER_USEC), compr_rate(in, ns));
+
+		in = atomic64_read(&st->decomp_in);
+		out = atomic64_read(&st->decomp_out);
+		ns = atomic64_read(&st->decomp_ns);
+		seq_printf(m, "\tdecompress: %lld calls, %llu -> %llu bytes, %llu us, %llu KiB/s\n",
+			   atomic64_read(&st->decomp_cnt), in, out,
+			   div_u64(ns, NSEC_PER_USEC), compr_rate(out, ns));
+	}
 }
@@ -32,6 +32,7 @@
 #include <linux/math64.h>
 #include <linux/uaccess.h>
 #include <linux/random.h>
+#include <linux/seq_file.h>
 #include "ubifs.h"
 
 static DEFINE_SPINLOCK(dbg_lock);
@@ -3001,6 +3002,25 @@ static const struct file_operations dfs_global_fops = {
 	.llseek = no_llseek,
 };
 
+static int dfs_compr_stats_show(struct seq_file *m, void *v)
+{
+	ubifs_compr_dump_stats(m);
+	return 0;
+}
+
+static int dfs_compr_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dfs_compr_stats_show, NULL);
+}
+
+static const struct file_operations dfs_compr_stats_fops = {
+	.open = dfs_compr_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+	.owner = THIS_MODULE,
+};
+
 /**
  * dbg_debugfs_init - initialize debugfs file-system.
  *
@@ -3066,6 +3086,12 @@ int dbg_debugfs_init(void)
 		goto out_remove;
 	dfs_tst_rcvry = dent;
 
+	fname = "compr_stats";
+	dent = debugfs_create_file(fname, S_IRUSR, dfs_rootdir, NULL,
+				   &dfs_compr_stats_fops);
+	if (IS_ERR_OR_NULL(dent))
+		goto out_remove;
+
 	return 0;
 
 out_remove:
@@ -137,7 +137,21 @@ struct inode *ubifs_new_inode(struct ubifs_info *c, const struct inode *dir,
 
 	ui->flags = inherit_flags(dir, mode);
 	ubifs_set_inode_flags(inode);
-	if (S_ISREG(mode))
+	if (S_ISDIR(dir->i_mode) &&
+	    (ubifs_inode(dir)->flags & UBIFS_COMPR_SET_FL) &&
+	    (S_ISREG(mode) || S_ISDIR(mode))) {
+		/*
+		 * The directory was given a compressor for its new inodes.
+		 * Only an explicit choice is inherited: mkfs.ubifs writes the
+		 * image compressor into every inode, which must not override
+		 * the "compr=" mount option.
+		 */
+		ui->compr_type = ubifs_inode(dir)->compr_type;
+		if (S_ISDIR(mode))
+			ui->flags |= UBIFS_COMPR_SET_FL;
+		else if (!ubifs_compr_present(ui->compr_type))
+			ui->compr_type = c->default_compr;
+	} else if (S_ISREG(mode))
 		ui->compr_type = c->default_compr;
 	else
 		ui->compr_type = UBIFS_COMPR_NONE;
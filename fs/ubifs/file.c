@@ -54,6 +54,8 @@
 #include <linux/mount.h>
 #include <linux/namei.h>
 #include <linux/slab.h>
+#include <linux/writeback.h>
+#include <linux/workqueue.h>
 
 static int read_block(struct inode *inode, void *addr, unsigned int block,
 		      struct ubifs_data_node *dn)
@@ -893,6 +895,37 @@ static int ubifs_readpage(struct file *file, struct page *page)
 	return 0;
 }
 
+/**
+ * finish_writepage - finish write-back of a page.
+ * @c: UBIFS file-system description object
+ * @page: the page
+ * @err: result of writing the page data nodes
+ */
+static void finish_writepage(struct ubifs_info *c, struct page *page, int err)
+{
+	struct inode *inode = page->mapping->host;
+
+	if (err) {
+		SetPageError(page);
+		ubifs_err("cannot write page %lu of inode %lu, error %d",
+			  page->index, inode->i_ino, err);
+		ubifs_ro_mode(c, err);
+	}
+
+	ubifs_assert(PagePrivate(page));
+	if (PageChecked(page))
+		release_new_page_budget(c);
+	else
+		release_existing_page_budget(c);
+
+	atomic_long_dec(&c->dirty_pg_cnt);
+	ClearPagePrivate(page);
+	ClearPageChecked(page);
+
+	unlock_page(page);
+	end_page_writeback(page);
+}
+
 static int do_writepage(struct page *page, int len)
 {
 	int err = 0, i, blen;
@@ -926,29 +959,194 @@ static int do_writepage(struct page *page, int len)
 		addr += blen;
 		len -= blen;
 	}
-	if (err) {
-		SetPageError(page);
-		ubifs_err("cannot write page %lu of inode %lu, error %d",
-			  page->index, inode->i_ino, err);
-		ubifs_ro_mode(c, err);
+	kunmap(page);
+
+	finish_writepage(c, page, err);
+	return err;
+}
+
+/*
+ * Write-back pipeline.
+ *
+ * When a range of pages of a compressed inode is written back,
+ * 'ubifs_writepages()' does not compress and write one page after the other.
+ * Instead, up to %UBIFS_WB_PIPE_DEPTH pages are handed to the @ubifs_compr_wq
+ * workqueue, which builds their data nodes on all CPUs, while the write-back
+ * task writes the already compressed nodes to the journal, strictly in page
+ * order. Compression thus overlaps with flash programming, and data nodes of
+ * an inode still reach the journal in the same order as before.
+ *
+ * Pages stay locked and under write-back until their nodes are written, so
+ * truncation is held off exactly as with 'do_writepage()'.
+ */
+#define UBIFS_WB_PIPE_DEPTH 8
+
+/**
+ * struct ubifs_wb_page - a page in the write-back pipeline.
+ * @list: link in the list of pages of the pipeline, in page order
+ * @work: compression work
+ * @done: completed when the data nodes are ready
+ * @c: UBIFS file-system description object
+ * @page: the page
+ * @len: how many bytes of the page to write
+ * @nodes: number of data nodes
+ * @key: keys of the data nodes
+ * @dlen: lengths of the data nodes
+ * @data: the data nodes
+ */
+struct ubifs_wb_page {
+	struct list_head list;
+	struct work_struct work;
+	struct completion done;
+	struct ubifs_info *c;
+	struct page *page;
+	int len;
+	int nodes;
+	union ubifs_key key[UBIFS_BLOCKS_PER_PAGE];
+	int dlen[UBIFS_BLOCKS_PER_PAGE];
+	struct ubifs_data_node *data[UBIFS_BLOCKS_PER_PAGE];
+};
+
+/**
+ * struct ubifs_wb_pipe - write-back pipeline of an inode.
+ * @pages: pages being compressed or waiting to be written, in page order
+ * @cnt: number of elements in @pages
+ * @err: first error, if any
+ */
+struct ubifs_wb_pipe {
+	struct list_head pages;
+	int cnt;
+	int err;
+};
+
+static void free_wb_page(struct ubifs_wb_page *wp)
+{
+	int i;
+
+	for (i = 0; i < UBIFS_BLOCKS_PER_PAGE; i++)
+		kfree(wp->data[i]);
+	kfree(wp);
+}
+
+static void wb_compress_work(struct work_struct *work)
+{
+	struct ubifs_wb_page *wp = container_of(work, struct ubifs_wb_page,
+						work);
+	struct inode *inode = wp->page->mapping->host;
+	unsigned int block;
+	int len = wp->len, blen;
+	void *addr;
+
+	addr = kmap(wp->page);
+	block = wp->page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT;
+	while (len && wp->nodes < UBIFS_BLOCKS_PER_PAGE) {
+		int i = wp->nodes;
+
+		blen = min_t(int, len, UBIFS_BLOCK_SIZE);
+		data_key_init(wp->c, &wp->key[i], inode->i_ino, block);
+		wp->dlen[i] = ubifs_jnl_prep_data(wp->c, inode, &wp->key[i],
+						  addr, blen, wp->data[i]);
+		wp->nodes += 1;
+		block += 1;
+		addr += blen;
+		len -= blen;
 	}
+	kunmap(wp->page);
 
-	ubifs_assert(PagePrivate(page));
-	if (PageChecked(page))
-		release_new_page_budget(c);
-	else
-		release_existing_page_budget(c);
+	complete(&wp->done);
+}
 
-	atomic_long_dec(&c->dirty_pg_cnt);
-	ClearPagePrivate(page);
-	ClearPageChecked(page);
+/**
+ * wb_pipe_write_one - write the oldest page of the pipeline.
+ * @pipe: the pipeline
+ *
+ * This function waits until the data nodes of the oldest page are
+ * compressed, writes them to the journal and finishes write-back of the page.
+ */
+static void wb_pipe_write_one(struct ubifs_wb_pipe *pipe)
+{
+	struct ubifs_wb_page *wp;
+	struct inode *inode;
+	int i, err = 0;
 
-	kunmap(page);
-	unlock_page(page);
-	end_page_writeback(page);
-	return err;
+	wp = list_first_entry(&pipe->pages, struct ubifs_wb_page, list);
+	list_del(&wp->list);
+	pipe->cnt -= 1;
+
+	wait_for_completion(&wp->done);
+
+	inode = wp->page->mapping->host;
+	for (i = 0; i < wp->nodes; i++) {
+		err = ubifs_jnl_write_data_node(wp->c, inode, &wp->key[i],
+						wp->data[i], wp->dlen[i]);
+		if (err)
+			break;
+	}
+
+	finish_writepage(wp->c, wp->page, err);
+	if (err && !pipe->err)
+		pipe->err = err;
+	free_wb_page(wp);
+}
+
+static void wb_pipe_flush(struct ubifs_wb_pipe *pipe)
+{
+	while (pipe->cnt)
+		wb_pipe_write_one(pipe);
+}
+
+/**
+ * wb_pipe_add - add a page to the write-back pipeline.
+ * @pipe: the pipeline
+ * @page: the page to write back
+ * @len: how many bytes of the page to write
+ *
+ * Like 'do_writepage()', but the page is only queued for compression. If the
+ * pipeline is full, the oldest page is written first. Falls back to
+ * 'do_writepage()' if memory is short.
+ */
+static int wb_pipe_add(struct ubifs_wb_pipe *pipe, struct page *page, int len)
+{
+	struct ubifs_info *c = page->mapping->host->i_sb->s_fs_info;
+	struct ubifs_wb_page *wp;
+	int i;
+
+	wp = kzalloc(sizeof(struct ubifs_wb_page), GFP_NOFS | __GFP_NOWARN);
+	if (!wp)
+		goto out_sync;
+
+	for (i = 0; i < UBIFS_BLOCKS_PER_PAGE; i++) {
+		wp->data[i] = kmalloc(COMPRESSED_DATA_NODE_BUF_SZ,
+				      GFP_NOFS | __GFP_NOWARN);
+		if (!wp->data[i]) {
+			free_wb_page(wp);
+			goto out_sync;
+		}
+	}
+
+	wp->c = c;
+	wp->page = page;
+	wp->len = len;
+	init_completion(&wp->done);
+	INIT_WORK(&wp->work, wb_compress_work);
+
+	/* Update radix tree tags */
+	set_page_writeback(page);
+
+	list_add_tail(&wp->list, &pipe->pages);
+	pipe->cnt += 1;
+	queue_work(ubifs_compr_wq, &wp->work);
+
+	if (pipe->cnt >= UBIFS_WB_PIPE_DEPTH)
+		wb_pipe_write_one(pipe);
+	return 0;
+
+out_sync:
+	wb_pipe_flush(pipe);
+	return do_writepage(page, len);
 }
 
+
 /*
  * When writing-back dirty inodes, VFS first writes-back pages belonging to the
  * inode, then the inode itself. For UBIFS this may cause a problem. Consider a
@@ -995,7 +1193,8 @@ static int do_writepage(struct page *page, int len)
  * on the page lock and it would not write the truncated inode node to the
  * journal before we have finished.
  */
-static int ubifs_writepage(struct page *page, struct writeback_control *wbc)
+static int __ubifs_writepage(struct page *page, struct writeback_control *wbc,
+			     struct ubifs_wb_pipe *pipe)
 {
 	struct inode *inode = page->mapping->host;
 	struct ubifs_inode *ui = ubifs_inode(inode);
@@ -1021,6 +1220,9 @@ static int ubifs_writepage(struct page *page, struct writeback_control *wbc)
 	/* Is the page fully inside @i_size? */
 	if (page->index < end_index) {
 		if (page->index >= synced_i_size >> PAGE_CACHE_SHIFT) {
+			/* Data nodes queued before must precede the inode */
+			if (pipe)
+				wb_pipe_flush(pipe);
 			err = inode->i_sb->s_op->write_inode(inode, NULL);
 			if (err)
 				goto out_unlock;
@@ -1033,6 +1235,8 @@ static int ubifs_writepage(struct page *page, struct writeback_control *wbc)
 			 * with this.
 			 */
 		}
+		if (pipe)
+			return wb_pipe_add(pipe, page, PAGE_CACHE_SIZE);
 		return do_writepage(page, PAGE_CACHE_SIZE);
 	}
 
@@ -1049,11 +1253,15 @@ static int ubifs_writepage(struct page *page, struct writeback_control *wbc)
 	kunmap_atomic(kaddr);
 
 	if (i_size > synced_i_size) {
+		if (pipe)
+			wb_pipe_flush(pipe);
 		err = inode->i_sb->s_op->write_inode(inode, NULL);
 		if (err)
 			goto out_unlock;
 	}
 
+	if (pipe)
+		return wb_pipe_add(pipe, page, len);
 	return do_writepage(page, len);
 
 out_unlock:
@@ -1061,6 +1269,47 @@ out_unlock:
 	return err;
 }
 
+static int ubifs_writepage(struct page *page, struct writeback_control *wbc)
+{
+	return __ubifs_writepage(page, wbc, NULL);
+}
+
+static int ubifs_writepage_pipe(struct page *page,
+				struct writeback_control *wbc, void *data)
+{
+	return __ubifs_writepage(page, wbc, data);
+}
+
+/**
+ * ubifs_writepages - write back a range of pages of an inode.
+ * @mapping: address space of the inode
+ * @wbc: write-back control
+ *
+ * Uses the write-back pipeline for inodes which are compressed, as long as
+ * there is more than one CPU to compress on. Otherwise pages are written one
+ * by one by 'ubifs_writepage()'.
+ */
+static int ubifs_writepages(struct address_space *mapping,
+			    struct writeback_control *wbc)
+{
+	struct ubifs_inode *ui = ubifs_inode(mapping->host);
+	struct ubifs_wb_pipe pipe;
+	int err;
+
+	if (num_online_cpus() < 2 || !(ui->flags & UBIFS_COMPR_FL) ||
+	    ui->compr_type == UBIFS_COMPR_NONE)
+		return generic_writepages(mapping, wbc);
+
+	INIT_LIST_HEAD(&pipe.pages);
+	pipe.cnt = 0;
+	pipe.err = 0;
+
+	err = write_cache_pages(mapping, wbc, ubifs_writepage_pipe, &pipe);
+	wb_pipe_flush(&pipe);
+
+	return err ? err : pipe.err;
+}
+
 /**
  * do_attr_changes - change inode attributes.
  * @inode: inode to change attributes for
@@ -1554,6 +1803,7 @@ static int ubifs_file_mmap(struct file *file, struct vm_area_struct *vma)
 const struct address_space_operations ubifs_file_address_operations = {
 	.readpage       = ubifs_readpage,
 	.writepage      = ubifs_writepage,
+	.writepages     = ubifs_writepages,
 	.write_begin    = ubifs_write_begin,
 	.write_end      = ubifs_write_end,
 	.invalidatepage = ubifs_invalidatepage,
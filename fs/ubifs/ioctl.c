@@ -124,7 +124,7 @@ static int setflags(struct inode *inode, int flags)
 		}
 	}
 
-	ui->flags = ioctl2ubifs(flags);
+	ui->flags = ioctl2ubifs(flags) | (ui->flags & UBIFS_COMPR_SET_FL);
 	ubifs_set_inode_flags(inode);
 	inode->i_ctime = ubifs_current_time(inode);
 	release = ui->dirty;
@@ -679,42 +679,28 @@ out_ro:
 }
 
 /**
- * ubifs_jnl_write_data - write a data node to the journal.
+ * ubifs_jnl_prep_data - prepare a data node for the journal.
  * @c: UBIFS file-system description object
  * @inode: inode the data node belongs to
  * @key: node key
  * @buf: buffer to write
  * @len: data length (must not exceed %UBIFS_BLOCK_SIZE)
+ * @data: buffer of %COMPRESSED_DATA_NODE_BUF_SZ bytes for the data node
  *
- * This function writes a data node to the journal. Returns %0 if the data node
- * was successfully written, and a negative error code in case of failure.
+ * This function builds the data node for @buf in @data, compressing it if
+ * compression is enabled for @inode, and returns the resulting node length.
+ * It does not touch the journal, so it may run in parallel with journal
+ * writes and be used ahead of them by the write-back pipeline.
  */
-int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
-			 const union ubifs_key *key, const void *buf, int len)
+int ubifs_jnl_prep_data(struct ubifs_info *c, const struct inode *inode,
+			const union ubifs_key *key, const void *buf, int len,
+			struct ubifs_data_node *data)
 {
-	struct ubifs_data_node *data;
-	int err, lnum, offs, compr_type, out_len;
-	int dlen = COMPRESSED_DATA_NODE_BUF_SZ, allocated = 1;
+	int compr_type, out_len;
 	struct ubifs_inode *ui = ubifs_inode(inode);
 
-	dbg_jnlk(key, "ino %lu, blk %u, len %d, key ",
-		(unsigned long)key_inum(c, key), key_block(c, key), len);
 	ubifs_assert(len <= UBIFS_BLOCK_SIZE);
 
-	data = kmalloc(dlen, GFP_NOFS | __GFP_NOWARN);
-	if (!data) {
-		/*
-		 * Fall-back to the write reserve buffer. Note, we might be
-		 * currently on the memory reclaim path, when the kernel is
-		 * trying to free some memory by writing out dirty pages. The
-		 * write reserve buffer helps us to guarantee that we are
-		 * always able to write the data.
-		 */
-		allocated = 0;
-		mutex_lock(&c->write_reserve_mutex);
-		data = c->write_reserve_buf;
-	}
-
 	data->ch.node_type = UBIFS_DATA_NODE;
 	key_write(c, key, &data->key);
 	data->size = cpu_to_le32(len);
@@ -726,17 +712,39 @@ int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 	else
 		compr_type = ui->compr_type;
 
-	out_len = dlen - UBIFS_DATA_NODE_SZ;
+	out_len = COMPRESSED_DATA_NODE_BUF_SZ - UBIFS_DATA_NODE_SZ;
 	ubifs_compress(buf, len, &data->data, &out_len, &compr_type);
 	ubifs_assert(out_len <= UBIFS_BLOCK_SIZE);
 
-	dlen = UBIFS_DATA_NODE_SZ + out_len;
 	data->compr_type = cpu_to_le16(compr_type);
+	return UBIFS_DATA_NODE_SZ + out_len;
+}
+
+/**
+ * ubifs_jnl_write_data_node - write a prepared data node to the journal.
+ * @c: UBIFS file-system description object
+ * @inode: inode the data node belongs to
+ * @key: node key
+ * @data: data node prepared by 'ubifs_jnl_prep_data()'
+ * @dlen: data node length
+ *
+ * Returns %0 if the data node was successfully written, and a negative error
+ * code in case of failure.
+ */
+int ubifs_jnl_write_data_node(struct ubifs_info *c, const struct inode *inode,
+			      const union ubifs_key *key,
+			      struct ubifs_data_node *data, int dlen)
+{
+	int err, lnum, offs;
+
+	dbg_jnlk(key, "ino %lu, blk %u, len %d, key ",
+		(unsigned long)key_inum(c, key), key_block(c, key),
+		le32_to_cpu(data->size));
 
 	/* Make reservation before allocating sequence numbers */
 	err = make_reservation(c, DATAHD, dlen);
 	if (err)
-		goto out_free;
+		return err;
 
 	err = write_node(c, DATAHD, data, dlen, &lnum, &offs);
 	if (err)
@@ -749,10 +757,6 @@ int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 		goto out_ro;
 
 	finish_reservation(c);
-	if (!allocated)
-		mutex_unlock(&c->write_reserve_mutex);
-	else
-		kfree(data);
 	return 0;
 
 out_release:
@@ -760,7 +764,43 @@ out_release:
 out_ro:
 	ubifs_ro_mode(c, err);
 	finish_reservation(c);
-out_free:
+	return err;
+}
+
+/**
+ * ubifs_jnl_write_data - write a data node to the journal.
+ * @c: UBIFS file-system description object
+ * @inode: inode the data node belongs to
+ * @key: node key
+ * @buf: buffer to write
+ * @len: data length (must not exceed %UBIFS_BLOCK_SIZE)
+ *
+ * This function writes a data node to the journal. Returns %0 if the data node
+ * was successfully written, and a negative error code in case of failure.
+ */
+int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
+			 const union ubifs_key *key, const void *buf, int len)
+{
+	struct ubifs_data_node *data;
+	int err, dlen, allocated = 1;
+
+	data = kmalloc(COMPRESSED_DATA_NODE_BUF_SZ, GFP_NOFS | __GFP_NOWARN);
+	if (!data) {
+		/*
+		 * Fall-back to the write reserve buffer. Note, we might be
+		 * currently on the memory reclaim path, when the kernel is
+		 * trying to free some memory by writing out dirty pages. The
+		 * write reserve buffer helps us to guarantee that we are
+		 * always able to write the data.
+		 */
+		allocated = 0;
+		mutex_lock(&c->write_reserve_mutex);
+		data = c->write_reserve_buf;
+	}
+
+	dlen = ubifs_jnl_prep_data(c, inode, key, buf, len, data);
+	err = ubifs_jnl_write_data_node(c, inode, key, data, dlen);
+
 	if (!allocated)
 		mutex_unlock(&c->write_reserve_mutex);
 	else
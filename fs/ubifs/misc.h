@@ -61,6 +61,34 @@ static inline int ubifs_zn_cow(const struct ubifs_znode *znode)
 	return !!test_bit(COW_ZNODE, &znode->flags);
 }
 
+/**
+ * ubifs_tnc_write_begin - start changing the TNC.
+ * @c: UBIFS file-system description object
+ *
+ * This function has to be called with @c->tnc_mutex locked before the TNC is
+ * changed, dirtied (which may copy-on-write znodes) or committed. It makes
+ * @c->tnc_seq odd, which makes lockless TNC walks fall back to @c->tnc_mutex
+ * and the entries of the per-CPU TNC look-up caches stale.
+ */
+static inline void ubifs_tnc_write_begin(struct ubifs_info *c)
+{
+	c->tnc_seq += 1;
+	smp_wmb();
+}
+
+/**
+ * ubifs_tnc_write_end - finish changing the TNC.
+ * @c: UBIFS file-system description object
+ *
+ * This function has to be called before @c->tnc_mutex is unlocked if
+ * 'ubifs_tnc_write_begin()' was called.
+ */
+static inline void ubifs_tnc_write_end(struct ubifs_info *c)
+{
+	smp_wmb();
+	c->tnc_seq += 1;
+}
+
 /**
  * ubifs_wake_up_bgt - wake up background thread.
  * @c: UBIFS file-system description object
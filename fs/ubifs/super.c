@@ -1043,6 +1043,8 @@ static int ubifs_parse_options(struct ubifs_info *c, char *options,
 				c->mount_opts.compr_type = UBIFS_COMPR_LZO;
 			else if (!strcmp(name, "zlib"))
 				c->mount_opts.compr_type = UBIFS_COMPR_ZLIB;
+			else if (!strcmp(name, "lz4"))
+				c->mount_opts.compr_type = UBIFS_COMPR_LZ4;
 			else {
 				ubifs_err("unknown compressor \"%s\"", name);
 				kfree(name);
@@ -1162,6 +1164,7 @@ static int mount_ubifs(struct ubifs_info *c)
 	int err;
 	long long x, y;
 	size_t sz;
+	ktime_t start = ktime_get();
 
 	c->ro_mount = !!(c->vfs_sb->s_flags & MS_RDONLY);
 	err = init_constants_early(c);
@@ -1203,6 +1206,10 @@ static int mount_ubifs(struct ubifs_info *c)
 	if (!c->bottom_up_buf)
 		goto out_free;
 
+	c->tnc_cache = alloc_percpu(struct ubifs_tnc_cache);
+	if (!c->tnc_cache)
+		goto out_free;
+
 	c->sbuf = vmalloc(c->leb_size);
 	if (!c->sbuf)
 		goto out_free;
@@ -1410,9 +1417,10 @@ static int mount_ubifs(struct ubifs_info *c)
 
 	c->mounting = 0;
 
-	ubifs_msg("mounted UBI device %d, volume %d, name \"%s\"%s",
+	ubifs_msg("mounted UBI device %d, volume %d, name \"%s\"%s in %lld ms",
 		  c->vi.ubi_num, c->vi.vol_id, c->vi.name,
-		  c->ro_mount ? ", R/O mode" : "");
+		  c->ro_mount ? ", R/O mode" : "",
+		  ktime_to_ms(ktime_sub(ktime_get(), start)));
 	x = (long long)c->main_lebs * c->leb_size;
 	y = (long long)c->log_lebs * c->leb_size + c->max_bud_bytes;
 	ubifs_msg("LEB size: %d bytes (%d KiB), min./max. I/O unit sizes: %d bytes/%d bytes",
@@ -1501,6 +1509,7 @@ out_free:
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
 	kfree(c->bottom_up_buf);
+	free_percpu(c->tnc_cache);
 	ubifs_debugging_exit(c);
 	return err;
 }
@@ -1540,6 +1549,7 @@ static void ubifs_umount(struct ubifs_info *c)
 	vfree(c->ileb_buf);
 	vfree(c->sbuf);
 	kfree(c->bottom_up_buf);
+	free_percpu(c->tnc_cache);
 	ubifs_debugging_exit(c);
 }
 
@@ -1969,6 +1979,8 @@ static struct ubifs_info *alloc_ubifs_info(struct ubi_volume_desc *ubi)
 		init_rwsem(&c->commit_sem);
 		mutex_init(&c->lp_mutex);
 		mutex_init(&c->tnc_mutex);
+		/* even and never matching a zeroed TNC look-up cache entry */
+		c->tnc_seq = 2;
 		mutex_init(&c->log_mutex);
 		mutex_init(&c->umount_mutex);
 		mutex_init(&c->bu_mutex);
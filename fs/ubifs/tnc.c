@@ -32,6 +32,7 @@
 
 #include <linux/crc32.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
 #include "ubifs.h"
 
 /*
@@ -230,6 +231,8 @@ static struct ubifs_znode *copy_znode(struct ubifs_info *c,
 		int i;
 		const int n = zn->child_cnt;
 
+		/* The copy must be complete before lockless walkers can see it */
+		smp_wmb();
 		/* The children now have new parent */
 		for (i = 0; i < n; i++) {
 			struct ubifs_zbranch *zbr = &zn->zbranch[i];
@@ -296,7 +299,7 @@ static struct ubifs_znode *dirty_cow_znode(struct ubifs_info *c,
 	} else
 		err = 0;
 
-	zbr->znode = zn;
+	rcu_assign_pointer(zbr->znode, zn);
 	zbr->lnum = 0;
 	zbr->offs = 0;
 	zbr->len = 0;
@@ -1394,6 +1397,247 @@ static int lookup_level0_dirty(struct ubifs_info *c, const union ubifs_key *key,
 	return 1;
 }
 
+static struct ubifs_tnc_cache_entry *
+tnc_cache_entry(struct ubifs_tnc_cache *cache, const union ubifs_key *key)
+{
+	u32 h = hash_32(key->u32[0] ^ key->u32[1] * 31, UBIFS_TNC_CACHE_BITS);
+
+	return &cache->e[h];
+}
+
+/**
+ * tnc_cache_add - remember a look-up in the TNC look-up cache.
+ * @c: UBIFS file-system description object
+ * @zbr: the leaf zbranch which was found
+ * @seq: @c->tnc_seq the look-up is valid for
+ *
+ * This function has to be called either with @c->tnc_mutex locked, or after a
+ * lockless look-up which was validated against @seq.
+ */
+static void tnc_cache_add(struct ubifs_info *c, const struct ubifs_zbranch *zbr,
+			  unsigned long seq)
+{
+	struct ubifs_tnc_cache_entry *e;
+
+	e = tnc_cache_entry(get_cpu_ptr(c->tnc_cache), &zbr->key);
+	key_copy(c, &zbr->key, &e->key);
+	e->lnum = zbr->lnum;
+	e->offs = zbr->offs;
+	e->len = zbr->len;
+	e->seq = seq;
+	put_cpu_ptr(c->tnc_cache);
+}
+
+/**
+ * tnc_cache_lookup - look up a key in the TNC look-up cache.
+ * @c: UBIFS file-system description object
+ * @key: the non-hashed key to look up
+ * @zbr: the leaf zbranch is returned here
+ * @gc_seq: the garbage collection sequence number is returned here
+ *
+ * This function does not need @c->tnc_mutex. It returns %1 and fills @zbr if
+ * the cache has an entry for @key and the TNC has not changed since the entry
+ * was added, and %0 otherwise. @gc_seq is sampled before the entry is
+ * validated, so that the caller can detect whether the leaf node was
+ * garbage-collected afterwards, just like 'ubifs_tnc_locate()' does after
+ * dropping @c->tnc_mutex.
+ */
+static int tnc_cache_lookup(struct ubifs_info *c, const union ubifs_key *key,
+			    struct ubifs_zbranch *zbr, int *gc_seq)
+{
+	struct ubifs_tnc_cache_entry *e;
+	unsigned long seq;
+	int hit = 0;
+
+	*gc_seq = c->gc_seq;
+	smp_rmb();
+
+	e = tnc_cache_entry(get_cpu_ptr(c->tnc_cache), key);
+	if (keys_eq(c, &e->key, key)) {
+		zbr->lnum = e->lnum;
+		zbr->offs = e->offs;
+		zbr->len = e->len;
+		seq = e->seq;
+		smp_rmb();
+		hit = seq == ACCESS_ONCE(c->tnc_seq);
+	}
+	put_cpu_ptr(c->tnc_cache);
+
+	if (hit) {
+		key_copy(c, key, &zbr->key);
+		zbr->leaf = NULL;
+	}
+	return hit;
+}
+
+/**
+ * search_zbranch_rcu - search znode branch without the TNC mutex.
+ * @c: UBIFS file-system description object
+ * @znode: znode to search in
+ * @key: key to search for
+ * @n: znode branch slot number is returned here
+ *
+ * This is 'ubifs_search_zbranch()' for lockless TNC walkers: @znode may be
+ * changed under our feet, so @znode->child_cnt is read only once and the
+ * result is not sanity checked. The caller validates it with @c->tnc_seq.
+ */
+static int search_zbranch_rcu(const struct ubifs_info *c,
+			      const struct ubifs_znode *znode,
+			      const union ubifs_key *key, int *n)
+{
+	int beg = 0, end = ACCESS_ONCE(znode->child_cnt), mid, cmp;
+	const struct ubifs_zbranch *zbr = &znode->zbranch[0];
+
+	if (end > c->fanout)
+		end = c->fanout;
+
+	while (end > beg) {
+		mid = (beg + end) >> 1;
+		cmp = keys_cmp(c, key, &zbr[mid].key);
+		if (cmp > 0)
+			beg = mid + 1;
+		else if (cmp < 0)
+			end = mid;
+		else {
+			*n = mid;
+			return 1;
+		}
+	}
+
+	*n = end - 1;
+	return 0;
+}
+
+/**
+ * lookup_level0_rcu - search for zero-level znode without the TNC mutex.
+ * @c: UBIFS file-system description object
+ * @key: the non-hashed key to lookup
+ * @zn: znode is returned here
+ * @n: znode branch slot number is returned here
+ *
+ * This is 'ubifs_lookup_level0()' for walkers which hold 'rcu_read_lock()'
+ * instead of @c->tnc_mutex. Returns %1 if @key was found, %0 if it was not,
+ * and %-EAGAIN if a znode on the path is not in memory, in which case the
+ * caller has to look up @key under @c->tnc_mutex. The result is only valid if
+ * @c->tnc_seq was even before the walk and is unchanged after it.
+ */
+static int lookup_level0_rcu(struct ubifs_info *c, const union ubifs_key *key,
+			     struct ubifs_znode **zn, int *n)
+{
+	struct ubifs_znode *znode;
+	unsigned long time = get_seconds();
+	int exact;
+
+	znode = rcu_dereference(c->zroot.znode);
+	if (unlikely(!znode))
+		return -EAGAIN;
+
+	while (1) {
+		/* Keep the shrinker off the znodes which are in use */
+		if (znode->time != time)
+			znode->time = time;
+
+		exact = search_zbranch_rcu(c, znode, key, n);
+
+		if (znode->level == 0)
+			break;
+
+		if (*n < 0)
+			*n = 0;
+		znode = rcu_dereference(znode->zbranch[*n].znode);
+		if (!znode)
+			return -EAGAIN;
+	}
+
+	*zn = znode;
+	return exact;
+}
+
+/**
+ * tnc_next_rcu - find next TNC entry without the TNC mutex.
+ * @c: UBIFS file-system description object
+ * @zn: znode is passed and returned here
+ * @n: znode branch slot number is passed and returned here
+ *
+ * This is 'tnc_next()' for walkers which hold 'rcu_read_lock()' instead of
+ * @c->tnc_mutex. Returns %0 if the next TNC entry is found, %-ENOENT if there
+ * is no next entry, and %-EAGAIN if a znode on the way is not in memory.
+ */
+static int tnc_next_rcu(struct ubifs_info *c, struct ubifs_znode **zn, int *n)
+{
+	struct ubifs_znode *znode = *zn;
+	int nn = *n;
+
+	nn += 1;
+	if (nn < ACCESS_ONCE(znode->child_cnt)) {
+		*n = nn;
+		return 0;
+	}
+	while (1) {
+		struct ubifs_znode *zp;
+
+		zp = rcu_dereference(znode->parent);
+		if (!zp)
+			return -ENOENT;
+		nn = ACCESS_ONCE(znode->iip) + 1;
+		znode = zp;
+		if (nn < min(ACCESS_ONCE(znode->child_cnt), c->fanout)) {
+			znode = rcu_dereference(znode->zbranch[nn].znode);
+			while (znode && znode->level != 0)
+				znode = rcu_dereference(znode->zbranch[0].znode);
+			if (!znode)
+				return -EAGAIN;
+			nn = 0;
+			break;
+		}
+	}
+	*zn = znode;
+	*n = nn;
+	return 0;
+}
+
+/**
+ * tnc_lookup_rcu - look up a leaf zbranch without the TNC mutex.
+ * @c: UBIFS file-system description object
+ * @key: the non-hashed key to look up
+ * @zbr: the leaf zbranch is returned here
+ * @gc_seq: the garbage collection sequence number is returned here
+ *
+ * This function walks the TNC under 'rcu_read_lock()'. Returns %1 and fills
+ * @zbr if @key was found, %-ENOENT if @key is not in the TNC, and %0 if the
+ * caller has to look @key up under @c->tnc_mutex, because the TNC was being
+ * changed, dirtied or committed during the walk, or a znode on the path is not
+ * in memory. @gc_seq is sampled like in 'tnc_cache_lookup()'.
+ */
+static int tnc_lookup_rcu(struct ubifs_info *c, const union ubifs_key *key,
+			  struct ubifs_zbranch *zbr, int *gc_seq)
+{
+	struct ubifs_znode *znode;
+	unsigned long seq;
+	int n, found;
+
+	*gc_seq = c->gc_seq;
+	seq = ACCESS_ONCE(c->tnc_seq);
+	if (seq & 1)
+		return 0;
+	smp_rmb();
+
+	rcu_read_lock();
+	found = lookup_level0_rcu(c, key, &znode, &n);
+	if (found == 1)
+		*zbr = znode->zbranch[n];
+	rcu_read_unlock();
+
+	smp_rmb();
+	if (found < 0 || seq != ACCESS_ONCE(c->tnc_seq))
+		return 0;
+	if (!found)
+		return -ENOENT;
+
+	tnc_cache_add(c, zbr, seq);
+	return 1;
+}
+
 /**
  * maybe_leb_gced - determine if a LEB may have been garbage collected.
  * @c: UBIFS file-system description object
@@ -1450,6 +1694,21 @@ int ubifs_tnc_locate(struct ubifs_info *c, const union ubifs_key *key,
 	struct ubifs_znode *znode;
 	struct ubifs_zbranch zbr, *zt;
 
+	if (!is_hash_key(c, key)) {
+		found = tnc_cache_lookup(c, key, &zbr, &gc_seq1);
+		if (!found)
+			found = tnc_lookup_rcu(c, key, &zbr, &gc_seq1);
+		if (found < 0)
+			return found;
+		if (found) {
+			if (lnum) {
+				*lnum = zbr.lnum;
+				*offs = zbr.offs;
+			}
+			goto read_unlocked;
+		}
+	}
+
 again:
 	mutex_lock(&c->tnc_mutex);
 	found = ubifs_lookup_level0(c, key, &znode, &n);
@@ -1480,8 +1739,10 @@ again:
 	/* Drop the TNC mutex prematurely and race with garbage collection */
 	zbr = znode->zbranch[n];
 	gc_seq1 = c->gc_seq;
+	tnc_cache_add(c, &zbr, c->tnc_seq);
 	mutex_unlock(&c->tnc_mutex);
 
+read_unlocked:
 	if (ubifs_get_wbuf(c, zbr.lnum)) {
 		/* We do not GC journal heads */
 		err = ubifs_tnc_read_node(c, &zbr, node);
@@ -1505,19 +1766,16 @@ out:
 }
 
 /**
- * ubifs_tnc_get_bu_keys - lookup keys for bulk-read.
+ * get_bu_keys - collect keys for bulk-read.
  * @c: UBIFS file-system description object
  * @bu: bulk-read parameters and results
+ * @rcu: walk the TNC under 'rcu_read_lock()' instead of @c->tnc_mutex
  *
- * Lookup consecutive data node keys for the same inode that reside
- * consecutively in the same LEB. This function returns zero in case of success
- * and a negative error code in case of failure.
- *
- * Note, if the bulk-read buffer length (@bu->buf_len) is known, this function
- * makes sure bulk-read nodes fit the buffer. Otherwise, this function prepares
- * maximum possible amount of nodes for bulk-read.
+ * This is a helper function for 'ubifs_tnc_get_bu_keys()' which does the TNC
+ * walk. The caller holds either @c->tnc_mutex or 'rcu_read_lock()', in the
+ * latter case %-EAGAIN is returned if a znode is not in memory.
  */
-int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
+static int get_bu_keys(struct ubifs_info *c, struct bu_info *bu, int rcu)
 {
 	int n, err = 0, lnum = -1, uninitialized_var(offs);
 	int uninitialized_var(len);
@@ -1528,9 +1786,11 @@ int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
 	bu->blk_cnt = 0;
 	bu->eof = 0;
 
-	mutex_lock(&c->tnc_mutex);
 	/* Find first key */
-	err = ubifs_lookup_level0(c, &bu->key, &znode, &n);
+	if (rcu)
+		err = lookup_level0_rcu(c, &bu->key, &znode, &n);
+	else
+		err = ubifs_lookup_level0(c, &bu->key, &znode, &n);
 	if (err < 0)
 		goto out;
 	if (err) {
@@ -1553,7 +1813,10 @@ int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
 		unsigned int next_block;
 
 		/* Find next key */
-		err = tnc_next(c, &znode, &n);
+		if (rcu)
+			err = tnc_next_rcu(c, &znode, &n);
+		else
+			err = tnc_next(c, &znode, &n);
 		if (err)
 			goto out;
 		zbr = &znode->zbranch[n];
@@ -1606,8 +1869,68 @@ out:
 		bu->eof = 1;
 		err = 0;
 	}
+	return err;
+}
+
+/**
+ * get_bu_keys_rcu - collect keys for bulk-read without the TNC mutex.
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read parameters and results
+ *
+ * This function returns %-EAGAIN if the caller has to collect the keys under
+ * @c->tnc_mutex, because the TNC was being changed, dirtied or committed
+ * during the walk, or a znode on the way is not in memory. Otherwise it
+ * returns what 'get_bu_keys()' returned.
+ */
+static int get_bu_keys_rcu(struct ubifs_info *c, struct bu_info *bu)
+{
+	unsigned long seq;
+	int err;
+
 	bu->gc_seq = c->gc_seq;
-	mutex_unlock(&c->tnc_mutex);
+	seq = ACCESS_ONCE(c->tnc_seq);
+	if (seq & 1)
+		return -EAGAIN;
+	smp_rmb();
+
+	rcu_read_lock();
+	err = get_bu_keys(c, bu, 1);
+	rcu_read_unlock();
+
+	smp_rmb();
+	if (seq != ACCESS_ONCE(c->tnc_seq))
+		return -EAGAIN;
+	return err;
+}
+
+/**
+ * ubifs_tnc_get_bu_keys - lookup keys for bulk-read.
+ * @c: UBIFS file-system description object
+ * @bu: bulk-read parameters and results
+ *
+ * Lookup consecutive data node keys for the same inode that reside
+ * consecutively in the same LEB. This function returns zero in case of success
+ * and a negative error code in case of failure.
+ *
+ * The TNC is walked without @c->tnc_mutex first, which only falls back to
+ * taking it if the walk raced with a TNC change or needs to read znodes.
+ *
+ * Note, if the bulk-read buffer length (@bu->buf_len) is known, this function
+ * makes sure bulk-read nodes fit the buffer. Otherwise, this function prepares
+ * maximum possible amount of nodes for bulk-read.
+ */
+int ubifs_tnc_get_bu_keys(struct ubifs_info *c, struct bu_info *bu)
+{
+	unsigned int block;
+	int err;
+
+	err = get_bu_keys_rcu(c, bu);
+	if (err == -EAGAIN) {
+		mutex_lock(&c->tnc_mutex);
+		err = get_bu_keys(c, bu, 0);
+		bu->gc_seq = c->gc_seq;
+		mutex_unlock(&c->tnc_mutex);
+	}
 	if (err)
 		return err;
 	/*
@@ -1938,6 +2261,8 @@ static void insert_zbranch(struct ubifs_znode *znode,
 		for (i = znode->child_cnt; i > n; i--)
 			znode->zbranch[i] = znode->zbranch[i - 1];
 
+	/* @zbr->znode may be new, publish it to lockless TNC walkers */
+	smp_wmb();
 	znode->zbranch[n] = *zbr;
 	znode->child_cnt += 1;
 
@@ -2014,6 +2339,8 @@ again:
 		return -ENOMEM;
 	zn->parent = zp;
 	zn->level = znode->level;
+	/* @zn gets linked to its children before it is fully set up */
+	smp_wmb();
 
 	/* Decide where to split */
 	if (znode->level == 0 && key_type(c, key) == UBIFS_DATA_KEY) {
@@ -2086,11 +2413,13 @@ do_split:
 	for (i = 0; i < move; i++) {
 		zn->zbranch[i] = znode->zbranch[keep + i];
 		/* Re-parent */
-		if (zn->level != 0)
+		if (zn->level != 0) {
 			if (zn->zbranch[i].znode) {
 				zn->zbranch[i].znode->parent = zn;
 				zn->zbranch[i].znode->iip = i;
 			}
+			znode->zbranch[keep + i].znode = NULL;
+		}
 	}
 
 	/* Insert new key and branch */
@@ -2141,7 +2470,7 @@ do_split:
 	c->zroot.lnum = 0;
 	c->zroot.offs = 0;
 	c->zroot.len = 0;
-	c->zroot.znode = zi;
+	rcu_assign_pointer(c->zroot.znode, zi);
 
 	zn->parent = zi;
 	zn->iip = 1;
@@ -2170,6 +2499,7 @@ int ubifs_tnc_add(struct ubifs_info *c, const union ubifs_key *key, int lnum,
 	struct ubifs_znode *znode;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	dbg_tnck(key, "%d:%d, len %d, key ", lnum, offs, len);
 	found = lookup_level0_dirty(c, key, &znode, &n);
 	if (!found) {
@@ -2193,6 +2523,7 @@ int ubifs_tnc_add(struct ubifs_info *c, const union ubifs_key *key, int lnum,
 		err = found;
 	if (!err)
 		err = dbg_check_tnc(c, 0);
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 
 	return err;
@@ -2219,6 +2550,7 @@ int ubifs_tnc_replace(struct ubifs_info *c, const union ubifs_key *key,
 	struct ubifs_znode *znode;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	dbg_tnck(key, "old LEB %d:%d, new LEB %d:%d, len %d, key ", old_lnum,
 		 old_offs, lnum, offs, len);
 	found = lookup_level0_dirty(c, key, &znode, &n);
@@ -2279,6 +2611,7 @@ int ubifs_tnc_replace(struct ubifs_info *c, const union ubifs_key *key,
 		err = dbg_check_tnc(c, 0);
 
 out_unlock:
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -2302,6 +2635,7 @@ int ubifs_tnc_add_nm(struct ubifs_info *c, const union ubifs_key *key,
 	struct ubifs_znode *znode;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	dbg_tnck(key, "LEB %d:%d, name '%.*s', key ",
 		 lnum, offs, nm->len, nm->name);
 	found = lookup_level0_dirty(c, key, &znode, &n);
@@ -2364,6 +2698,7 @@ int ubifs_tnc_add_nm(struct ubifs_info *c, const union ubifs_key *key,
 			struct qstr noname = { .name = "" };
 
 			err = dbg_check_tnc(c, 0);
+			ubifs_tnc_write_end(c);
 			mutex_unlock(&c->tnc_mutex);
 			if (err)
 				return err;
@@ -2374,6 +2709,7 @@ int ubifs_tnc_add_nm(struct ubifs_info *c, const union ubifs_key *key,
 out_unlock:
 	if (!err)
 		err = dbg_check_tnc(c, 0);
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -2438,7 +2774,7 @@ static int tnc_delete(struct ubifs_info *c, struct ubifs_znode *znode, int n)
 			atomic_long_inc(&c->clean_zn_cnt);
 			atomic_long_inc(&ubifs_clean_zn_cnt);
 		} else
-			kfree(znode);
+			kfree_rcu(znode, rcu);
 		znode = zp;
 	} while (znode->child_cnt == 1); /* while removing last child */
 
@@ -2450,6 +2786,7 @@ static int tnc_delete(struct ubifs_info *c, struct ubifs_znode *znode, int n)
 		if (znode->zbranch[i].znode)
 			znode->zbranch[i].znode->iip = i;
 	}
+	znode->zbranch[znode->child_cnt].znode = NULL;
 
 	/*
 	 * If this is the root and it has only 1 child then
@@ -2486,7 +2823,7 @@ static int tnc_delete(struct ubifs_info *c, struct ubifs_znode *znode, int n)
 				atomic_long_inc(&c->clean_zn_cnt);
 				atomic_long_inc(&ubifs_clean_zn_cnt);
 			} else
-				kfree(zp);
+				kfree_rcu(zp, rcu);
 		}
 	}
 
@@ -2506,6 +2843,7 @@ int ubifs_tnc_remove(struct ubifs_info *c, const union ubifs_key *key)
 	struct ubifs_znode *znode;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	dbg_tnck(key, "key ");
 	found = lookup_level0_dirty(c, key, &znode, &n);
 	if (found < 0) {
@@ -2518,6 +2856,7 @@ int ubifs_tnc_remove(struct ubifs_info *c, const union ubifs_key *key)
 		err = dbg_check_tnc(c, 0);
 
 out_unlock:
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -2537,6 +2876,7 @@ int ubifs_tnc_remove_nm(struct ubifs_info *c, const union ubifs_key *key,
 	struct ubifs_znode *znode;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	dbg_tnck(key, "%.*s, key ", nm->len, nm->name);
 	err = lookup_level0_dirty(c, key, &znode, &n);
 	if (err < 0)
@@ -2567,6 +2907,7 @@ int ubifs_tnc_remove_nm(struct ubifs_info *c, const union ubifs_key *key,
 out_unlock:
 	if (!err)
 		err = dbg_check_tnc(c, 0);
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -2608,6 +2949,7 @@ int ubifs_tnc_remove_range(struct ubifs_info *c, union ubifs_key *from_key,
 	union ubifs_key *key;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	while (1) {
 		/* Find first level 0 znode that contains keys to remove */
 		err = ubifs_lookup_level0(c, from_key, &znode, &n);
@@ -2669,6 +3011,7 @@ int ubifs_tnc_remove_range(struct ubifs_info *c, union ubifs_key *from_key,
 out_unlock:
 	if (!err)
 		err = dbg_check_tnc(c, 0);
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -2863,7 +3206,7 @@ static void tnc_destroy_cnext(struct ubifs_info *c)
 
 		cnext = cnext->cnext;
 		if (ubifs_zn_obsolete(znode))
-			kfree(znode);
+			kfree_rcu(znode, rcu);
 	} while (cnext && cnext != c->cnext);
 }
 
@@ -3257,6 +3600,7 @@ int ubifs_dirty_idx_node(struct ubifs_info *c, union ubifs_key *key, int level,
 	int err = 0;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	znode = lookup_znode(c, key, level, lnum, offs);
 	if (!znode)
 		goto out_unlock;
@@ -3271,6 +3615,7 @@ int ubifs_dirty_idx_node(struct ubifs_info *c, union ubifs_key *key, int level,
 	}
 
 out_unlock:
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -743,6 +743,7 @@ int ubifs_tnc_start_commit(struct ubifs_info *c, struct ubifs_zbranch *zroot)
 	int err = 0, cnt;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 	err = dbg_check_tnc(c, 1);
 	if (err)
 		goto out;
@@ -784,6 +785,7 @@ int ubifs_tnc_start_commit(struct ubifs_info *c, struct ubifs_zbranch *zroot)
 	c->bi.uncommitted_idx = 0;
 	c->bi.min_idx_lebs = ubifs_calc_min_idx_lebs(c);
 	spin_unlock(&c->space_lock);
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 
 	dbg_cmt("number of index LEBs %d", c->lst.idx_lebs);
@@ -793,6 +795,7 @@ int ubifs_tnc_start_commit(struct ubifs_info *c, struct ubifs_zbranch *zroot)
 out_free:
 	free_idx_lebs(c);
 out:
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 	return err;
 }
@@ -999,7 +1002,7 @@ static void free_obsolete_znodes(struct ubifs_info *c)
 		znode = cnext;
 		cnext = znode->cnext;
 		if (ubifs_zn_obsolete(znode))
-			kfree(znode);
+			kfree_rcu(znode, rcu);
 		else {
 			znode->cnext = NULL;
 			atomic_long_inc(&c->clean_zn_cnt);
@@ -1057,6 +1060,7 @@ int ubifs_tnc_end_commit(struct ubifs_info *c)
 		return err;
 
 	mutex_lock(&c->tnc_mutex);
+	ubifs_tnc_write_begin(c);
 
 	dbg_cmt("TNC height is %d", c->zroot.znode->level + 1);
 
@@ -1066,6 +1070,7 @@ int ubifs_tnc_end_commit(struct ubifs_info *c)
 	kfree(c->ilebs);
 	c->ilebs = NULL;
 
+	ubifs_tnc_write_end(c);
 	mutex_unlock(&c->tnc_mutex);
 
 	return 0;
@@ -237,18 +237,22 @@ long ubifs_destroy_tnc_subtree(struct ubifs_znode *znode)
 			if (!zn->zbranch[n].znode)
 				continue;
 
-			if (zn->level > 0 &&
-			    !ubifs_zn_dirty(zn->zbranch[n].znode))
-				clean_freed += 1;
-
 			cond_resched();
-			kfree(zn->zbranch[n].znode);
+			if (zn->level == 0) {
+				/* A cached leaf node, not a znode (LNC) */
+				kfree(zn->zbranch[n].leaf);
+				continue;
+			}
+
+			if (!ubifs_zn_dirty(zn->zbranch[n].znode))
+				clean_freed += 1;
+			kfree_rcu(zn->zbranch[n].znode, rcu);
 		}
 
 		if (zn == znode) {
 			if (!ubifs_zn_dirty(zn))
 				clean_freed += 1;
-			kfree(zn);
+			kfree_rcu(zn, rcu);
 			return clean_freed;
 		}
 
@@ -433,10 +437,11 @@ struct ubifs_znode *ubifs_load_znode(struct ubifs_info *c,
 	 */
 	atomic_long_inc(&ubifs_clean_zn_cnt);
 
-	zbr->znode = znode;
 	znode->parent = parent;
 	znode->time = get_seconds();
 	znode->iip = iip;
+	/* Lockless TNC walkers may follow @zbr->znode right away */
+	rcu_assign_pointer(zbr->znode, znode);
 
 	return znode;
 
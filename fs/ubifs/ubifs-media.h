@@ -309,10 +309,13 @@ enum {
  * UBIFS_APPEND_FL: writes to the inode may only append data
  * UBIFS_DIRSYNC_FL: I/O on this directory inode has to be synchronous
  * UBIFS_XATTR_FL: this inode is the inode for an extended attribute value
+ * UBIFS_COMPR_SET_FL: @compr_type was chosen with the "trusted.ubifs.compr"
+ *                     attribute, so a directory passes it on to new inodes
  *
  * Note, these are on-flash flags which correspond to ioctl flags
  * (@FS_COMPR_FL, etc). They have the same values now, but generally, do not
- * have to be the same.
+ * have to be the same. %UBIFS_COMPR_SET_FL has no ioctl counterpart; it uses
+ * a high bit to stay clear of flags added by other UBIFS implementations.
  */
 enum {
 	UBIFS_COMPR_FL     = 0x01,
@@ -321,6 +324,7 @@ enum {
 	UBIFS_APPEND_FL    = 0x08,
 	UBIFS_DIRSYNC_FL   = 0x10,
 	UBIFS_XATTR_FL     = 0x20,
+	UBIFS_COMPR_SET_FL = 0x8000,
 };
 
 /* Inode flag bits used by UBIFS */
@@ -332,12 +336,19 @@ enum {
  * UBIFS_COMPR_NONE: no compression
  * UBIFS_COMPR_LZO: LZO compression
  * UBIFS_COMPR_ZLIB: ZLIB compression
+ * UBIFS_COMPR_ZSTD: ZSTD compression, reserved, not supported
+ * UBIFS_COMPR_LZ4: LZ4 compression
  * UBIFS_COMPR_TYPES_CNT: count of supported compression types
+ *
+ * Type 3 is used for ZSTD by other UBIFS implementations. It is reserved so
+ * that their images are refused instead of being decoded as something else.
  */
 enum {
 	UBIFS_COMPR_NONE,
 	UBIFS_COMPR_LZO,
 	UBIFS_COMPR_ZLIB,
+	UBIFS_COMPR_ZSTD,
+	UBIFS_COMPR_LZ4,
 	UBIFS_COMPR_TYPES_CNT,
 };
 
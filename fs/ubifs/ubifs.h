@@ -33,6 +33,7 @@
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
 #include <linux/rwsem.h>
+#include <linux/rcupdate.h>
 #include <linux/mtd/ubi.h>
 #include <linux/pagemap.h>
 #include <linux/backing-dev.h>
@@ -159,6 +160,10 @@
 /* Maximum number of data nodes to bulk-read */
 #define UBIFS_MAX_BULK_READ 32
 
+/* Number of entries in the per-CPU TNC look-up cache, a power of 2 */
+#define UBIFS_TNC_CACHE_BITS 5
+#define UBIFS_TNC_CACHE_SIZE (1 << UBIFS_TNC_CACHE_BITS)
+
 /*
  * Lockdep classes for UBIFS inode @ui_mutex.
  */
@@ -400,7 +405,7 @@ struct ubifs_inode {
 	unsigned int dirty:1;
 	unsigned int xattr:1;
 	unsigned int bulk_read:1;
-	unsigned int compr_type:2;
+	unsigned int compr_type:3;
 	struct mutex ui_mutex;
 	spinlock_t ui_lock;
 	loff_t synced_i_size;
@@ -725,6 +730,31 @@ struct ubifs_jhead {
 	unsigned int grouped:1;
 };
 
+/**
+ * struct ubifs_tnc_cache_entry - a cached key to leaf node mapping.
+ * @key: key of the leaf node
+ * @lnum: LEB number of the leaf node
+ * @offs: offset of the leaf node within @lnum
+ * @len: length of the leaf node
+ * @seq: @c->tnc_seq when the entry was added, the entry is valid only while
+ *       @c->tnc_seq stays the same
+ */
+struct ubifs_tnc_cache_entry {
+	union ubifs_key key;
+	int lnum;
+	int offs;
+	int len;
+	unsigned long seq;
+};
+
+/**
+ * struct ubifs_tnc_cache - per-CPU cache of recent TNC look-ups.
+ * @e: cache entries, indexed by a hash of the key
+ */
+struct ubifs_tnc_cache {
+	struct ubifs_tnc_cache_entry e[UBIFS_TNC_CACHE_SIZE];
+};
+
 /**
  * struct ubifs_zbranch - key/coordinate/length branch stored in znodes.
  * @key: key
@@ -757,10 +787,15 @@ struct ubifs_zbranch {
  * @lnum: LEB number of the corresponding indexing node
  * @offs: offset of the corresponding indexing node
  * @len: length  of the corresponding indexing node
+ * @rcu: RCU head used to free the znode
  * @zbranch: array of znode branches (@c->fanout elements)
  *
  * Note! The @lnum, @offs, and @len fields are not really needed - we have them
  * only for internal consistency check. They could be removed to save some RAM.
+ *
+ * The @znode pointers of the unused slots of @zbranch (from @child_cnt on) of
+ * an indexing znode are kept %NULL, so that a lockless walker which read a
+ * stale @child_cnt does not follow a pointer to a long-freed znode.
  */
 struct ubifs_znode {
 	struct ubifs_znode *parent;
@@ -774,6 +809,7 @@ struct ubifs_znode {
 	int lnum;
 	int offs;
 	int len;
+	struct rcu_head rcu;
 	struct ubifs_zbranch zbranch[];
 };
 
@@ -815,20 +851,65 @@ struct ubifs_node_range {
 	int max_len;
 };
 
+/**
+ * struct ubifs_compr_ctx - compression context.
+ * @list: link in the list of idle contexts of the compressor
+ * @cc: cryptoapi compressor handle
+ *
+ * A cryptoapi compressor handle carries the compressor work memory, so it
+ * can only be used by one task at a time. Each compressor keeps a pool of
+ * these, one per possible CPU, so that several tasks may compress and
+ * decompress in parallel.
+ */
+struct ubifs_compr_ctx {
+	struct list_head list;
+	struct crypto_comp *cc;
+};
+
+/**
+ * struct ubifs_compr_stats - compressor throughput counters.
+ * @comp_cnt: how many times data was passed to the compressor
+ * @comp_in: bytes passed to the compressor
+ * @comp_out: bytes produced by the compressor
+ * @comp_ns: time spent compressing, in nanoseconds
+ * @decomp_cnt: how many times data was decompressed
+ * @decomp_in: bytes passed to the decompressor
+ * @decomp_out: bytes produced by the decompressor
+ * @decomp_ns: time spent decompressing, in nanoseconds
+ * @ctx_waits: how many times a task had to wait for an idle context
+ */
+struct ubifs_compr_stats {
+	atomic64_t comp_cnt;
+	atomic64_t comp_in;
+	atomic64_t comp_out;
+	atomic64_t comp_ns;
+	atomic64_t decomp_cnt;
+	atomic64_t decomp_in;
+	atomic64_t decomp_out;
+	atomic64_t decomp_ns;
+	atomic64_t ctx_waits;
+};
+
 /**
  * struct ubifs_compressor - UBIFS compressor description structure.
  * @compr_type: compressor type (%UBIFS_COMPR_LZO, etc)
- * @cc: cryptoapi compressor handle
- * @comp_mutex: mutex used during compression
- * @decomp_mutex: mutex used during decompression
+ * @ctx: array of compression contexts
+ * @ctx_cnt: number of elements in @ctx
+ * @idle_ctx: list of contexts which are not in use
+ * @ctx_lock: protects @idle_ctx
+ * @ctx_wait: tasks waiting for a context to become idle
+ * @stats: throughput counters
  * @name: compressor name
  * @capi_name: cryptoapi compressor name
  */
 struct ubifs_compressor {
 	int compr_type;
-	struct crypto_comp *cc;
-	struct mutex *comp_mutex;
-	struct mutex *decomp_mutex;
+	struct ubifs_compr_ctx *ctx;
+	int ctx_cnt;
+	struct list_head idle_ctx;
+	spinlock_t ctx_lock;
+	wait_queue_head_t ctx_wait;
+	struct ubifs_compr_stats stats;
 	const char *name;
 	const char *capi_name;
 };
@@ -936,7 +1017,7 @@ struct ubifs_mount_opts {
 	unsigned int bulk_read:2;
 	unsigned int chk_data_crc:2;
 	unsigned int override_compr:1;
-	unsigned int compr_type:2;
+	unsigned int compr_type:3;
 };
 
 /**
@@ -1025,6 +1106,14 @@ struct ubifs_debug_info;
  *
  * @tnc_mutex: protects the Tree Node Cache (TNC), @zroot, @cnext, @enext, and
  *             @calc_idx_sz
+ * @tnc_seq: TNC modification sequence number, odd while the TNC is being
+ *           changed under @tnc_mutex (see 'ubifs_tnc_write_begin()')
+ * @tnc_cache: per-CPU cache of recent look-ups of non-hashed keys, used by
+ *             'ubifs_tnc_locate()' without taking @tnc_mutex
+ *
+ * Znodes are freed only after an RCU grace period, so that the TNC may be
+ * walked under 'rcu_read_lock()' instead of @tnc_mutex. Such a walk is only
+ * trusted if @tnc_seq was even and did not change while it went on.
  * @zroot: zbranch which points to the root index node and znode
  * @cnext: next znode to commit
  * @enext: next znode to commit to empty space
@@ -1260,10 +1349,12 @@ struct ubifs_info {
 	unsigned int space_fixup:1;
 	unsigned int no_chk_data_crc:1;
 	unsigned int bulk_read:1;
-	unsigned int default_compr:2;
+	unsigned int default_compr:3;
 	unsigned int rw_incompat:1;
 
 	struct mutex tnc_mutex;
+	unsigned long tnc_seq;
+	struct ubifs_tnc_cache __percpu *tnc_cache;
 	struct ubifs_zbranch zroot;
 	struct ubifs_znode *cnext;
 	struct ubifs_znode *enext;
@@ -1464,6 +1555,7 @@ extern const struct inode_operations ubifs_dir_inode_operations;
 extern const struct inode_operations ubifs_symlink_inode_operations;
 extern struct backing_dev_info ubifs_backing_dev_info;
 extern struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
+extern struct workqueue_struct *ubifs_compr_wq;
 
 /* io.c */
 void ubifs_ro_mode(struct ubifs_info *c, int err);
@@ -1525,6 +1617,12 @@ int ubifs_consolidate_log(struct ubifs_info *c);
 int ubifs_jnl_update(struct ubifs_info *c, const struct inode *dir,
 		     const struct qstr *nm, const struct inode *inode,
 		     int deletion, int xent);
+int ubifs_jnl_prep_data(struct ubifs_info *c, const struct inode *inode,
+			const union ubifs_key *key, const void *buf, int len,
+			struct ubifs_data_node *data);
+int ubifs_jnl_write_data_node(struct ubifs_info *c, const struct inode *inode,
+			      const union ubifs_key *key,
+			      struct ubifs_data_node *data, int dlen);
 int ubifs_jnl_write_data(struct ubifs_info *c, const struct inode *inode,
 			 const union ubifs_key *key, const void *buf, int len);
 int ubifs_jnl_write_inode(struct ubifs_info *c, const struct inode *inode);
@@ -1769,8 +1867,11 @@ long ubifs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
 #endif
 
 /* compressor.c */
+struct seq_file;
 int __init ubifs_compressors_init(void);
 void ubifs_compressors_exit(void);
+void ubifs_compr_dump_stats(struct seq_file *m);
+int ubifs_compr_lookup(const char *name, int len);
 void ubifs_compress(const void *in_buf, int in_len, void *out_buf, int *out_len,
 		    int *compr_type);
 int ubifs_decompress(const void *buf, int len, void *out, int *out_len,
@@ -52,6 +52,10 @@
  * in the VFS inode cache. The xentries are cached in the LNC cache (see
  * tnc.c).
  *
+ * The "trusted.ubifs.compr" extended attribute is special: it is not stored
+ * on the media but reads and changes the compressor of the inode (see
+ * 'compr_xattr_set()').
+ *
  * ACL support is not implemented.
  */
 
@@ -293,6 +297,77 @@ static struct inode *iget_xattr(struct ubifs_info *c, ino_t inum)
 	return ERR_PTR(-EINVAL);
 }
 
+/* Name of the extended attribute selecting the compressor of an inode */
+#define UBIFS_COMPR_XATTR XATTR_TRUSTED_PREFIX "ubifs.compr"
+
+static int compr_xattr_get(struct inode *host, void *buf, size_t size)
+{
+	const struct ubifs_inode *ui = ubifs_inode(host);
+	const char *name = ubifs_compr_name(ui->compr_type);
+	size_t len = strlen(name);
+
+	/* A directory only has a compressor if one was set */
+	if (S_ISDIR(host->i_mode) && !(ui->flags & UBIFS_COMPR_SET_FL))
+		return -ENODATA;
+
+	if (buf) {
+		if (len > size)
+			return -ERANGE;
+		memcpy(buf, name, len);
+	}
+	return len;
+}
+
+/**
+ * compr_xattr_set - change the compressor of an inode.
+ * @c: UBIFS file-system description object
+ * @host: regular file or directory inode
+ * @compr_type: new compressor type
+ * @explicit: the compressor was chosen by the user, not reset to the default
+ *
+ * For a regular file, @compr_type is used for all data written from now on;
+ * data which is already on the media stays as it is. For a directory set
+ * explicitly, it is inherited by files and directories created in it later;
+ * otherwise they get the default compressor of the file-system. The
+ * compressor type and the %UBIFS_COMPR_SET_FL flag are stored in the inode
+ * node, so they persist. Returns zero in case of success and a negative error
+ * code in case of failure.
+ */
+static int compr_xattr_set(struct ubifs_info *c, struct inode *host,
+			   int compr_type, int explicit)
+{
+	struct ubifs_inode *ui = ubifs_inode(host);
+	struct ubifs_budget_req req = { .dirtied_ino = 1,
+					.dirtied_ino_d = ui->data_len };
+	int err, release;
+
+	if (!S_ISREG(host->i_mode) && !S_ISDIR(host->i_mode))
+		return -EPERM;
+	if (!ubifs_compr_present(compr_type))
+		return -EOPNOTSUPP;
+
+	err = ubifs_budget_space(c, &req);
+	if (err)
+		return err;
+
+	mutex_lock(&ui->ui_mutex);
+	ui->compr_type = compr_type;
+	if (explicit)
+		ui->flags |= UBIFS_COMPR_SET_FL;
+	else
+		ui->flags &= ~UBIFS_COMPR_SET_FL;
+	host->i_ctime = ubifs_current_time(host);
+	release = ui->dirty;
+	mark_inode_dirty_sync(host);
+	mutex_unlock(&ui->ui_mutex);
+
+	if (release)
+		ubifs_release_budget(c, &req);
+	if (IS_SYNC(host))
+		err = write_inode_now(host, 1);
+	return err;
+}
+
 int ubifs_setxattr(struct dentry *dentry, const char *name,
 		   const void *value, size_t size, int flags)
 {
@@ -310,6 +385,17 @@ int ubifs_setxattr(struct dentry *dentry, const char *name,
 	if (size > UBIFS_MAX_INO_DATA)
 		return -ERANGE;
 
+	if (!strcmp(name, UBIFS_COMPR_XATTR)) {
+		/* Tolerate a terminating zero or newline in the value */
+		while (size && (((const char *)value)[size - 1] == '\0' ||
+				((const char *)value)[size - 1] == '\n'))
+			size -= 1;
+		type = ubifs_compr_lookup(value, size);
+		if (type < 0)
+			return type;
+		return compr_xattr_set(c, host, type, 1);
+	}
+
 	type = check_namespace(&nm);
 	if (type < 0)
 		return type;
@@ -370,6 +456,9 @@ ssize_t ubifs_getxattr(struct dentry *dentry, const char *name, void *buf,
 	dbg_gen("xattr '%s', ino %lu ('%.*s'), buf size %zd", name,
 		host->i_ino, dentry->d_name.len, dentry->d_name.name, size);
 
+	if (!strcmp(name, UBIFS_COMPR_XATTR))
+		return compr_xattr_get(host, buf, size);
+
 	err = check_namespace(&nm);
 	if (err < 0)
 		return err;
@@ -533,6 +622,10 @@ int ubifs_removexattr(struct dentry *dentry, const char *name)
 		host->i_ino, dentry->d_name.len, dentry->d_name.name);
 	ubifs_assert(mutex_is_locked(&host->i_mutex));
 
+	if (!strcmp(name, UBIFS_COMPR_XATTR))
+		return compr_xattr_set(c, host, S_ISREG(host->i_mode) ?
+				       c->default_compr : UBIFS_COMPR_NONE, 0);
+
 	err = check_namespace(&nm);
 	if (err < 0)
 		return err;
@@ -16,6 +16,7 @@
 #include <linux/completion.h>
 #include <linux/kobject.h>
 #include <linux/notifier.h>
+#include <linux/percpu.h>
 #include <linux/sysfs.h>
 
 /*********************************************************************
@@ -417,6 +418,26 @@ int __cpufreq_driver_target(struct cpufreq_policy *policy,
 int cpufreq_register_governor(struct cpufreq_governor *governor);
 void cpufreq_unregister_governor(struct cpufreq_governor *governor);
 
+#ifdef CONFIG_CPU_FREQ
+DECLARE_PER_CPU(unsigned int, cpufreq_net_load);
+
+/**
+ * cpufreq_report_net_load - report network RX pressure on this CPU
+ * @load: 0-100, e.g. RX queue occupancy, or 100 when the NAPI budget ran out
+ *
+ * Called from NAPI poll.  The ondemand governor folds the peak value seen
+ * since its previous sample into the CPU load, so packet bursts raise the
+ * frequency at the next sample even when the CPU still has idle time.
+ */
+static inline void cpufreq_report_net_load(unsigned int load)
+{
+	if (load > __this_cpu_read(cpufreq_net_load))
+		__this_cpu_write(cpufreq_net_load, load);
+}
+#else
+static inline void cpufreq_report_net_load(unsigned int load) { }
+#endif
+
 /* CPUFREQ DEFAULT GOVERNOR */
 /*
  * Performance governor is fallback governor if any other gov failed to auto
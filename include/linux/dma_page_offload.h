@@ -0,0 +1,33 @@
+/*
+ * Page copy and clear offload to a dmaengine memcpy channel
+ *
+ * This file is licensed under the terms of the GNU General Public
+ * License version 2.  This program is licensed "as is" without any
+ * warranty of any kind, whether express or implied.
+ */
+
+#ifndef __DMA_PAGE_OFFLOAD_H__
+#define __DMA_PAGE_OFFLOAD_H__
+
+#include <linux/errno.h>
+
+struct page;
+
+#ifdef CONFIG_DMA_PAGE_OFFLOAD
+int dma_offload_copy_pages(struct page *dst, struct page *src,
+			   unsigned int nr_pages);
+int dma_offload_clear_pages(struct page *page, unsigned int nr_pages);
+#else
+static inline int dma_offload_copy_pages(struct page *dst, struct page *src,
+					 unsigned int nr_pages)
+{
+	return -ENODEV;
+}
+static inline int dma_offload_clear_pages(struct page *page,
+					  unsigned int nr_pages)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif /* __DMA_PAGE_OFFLOAD_H__ */
@@ -431,6 +431,12 @@ extern bool force_irqthreads;
 #define or_softirq_pending(x)  (local_softirq_pending() |= (x))
 #endif
 
+#ifdef CONFIG_IRQ_LATENCY_HIST
+extern void irq_latency_softirq_entry(void);
+#else
+static inline void irq_latency_softirq_entry(void) { }
+#endif
+
 /* Some architectures might implement lazy enabling/disabling of
  * interrupts. In some cases, such as stop_machine, we might want
  * to ensure that after a local_irq_disable(), interrupts have
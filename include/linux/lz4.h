@@ -0,0 +1,64 @@
+#ifndef __LZ4_H__
+#define __LZ4_H__
+/*
+ * LZ4 Kernel Interface
+ *
+ * LZ4 is a byte oriented LZ77 compressor designed for very fast
+ * decompression, see http://code.google.com/p/lz4/ for the format.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#define LZ4_MEM_COMPRESS	(4096 * sizeof(unsigned int))
+#define LZ4HC_MEM_COMPRESS	(32768 * sizeof(unsigned int) + \
+				 65536 * sizeof(unsigned short))
+
+/*
+ * lz4_compressbound()
+ * Provides the maximum size that LZ4 may output in a "worst case" scenario
+ * (input data not compressible)
+ */
+static inline size_t lz4_compressbound(size_t isize)
+{
+	return isize + (isize / 255) + 16;
+}
+
+/*
+ * lz4_compress()
+ *	src     : source address of the original data
+ *	src_len : size of the original data
+ *	dst	: output buffer address of the compressed data
+ *	dst_len : on entry the size of dst, on return the compressed size;
+ *		  dst does not need to be larger than lz4_compressbound()
+ *	wrkmem  : address of the working memory, of LZ4_MEM_COMPRESS bytes
+ *	return  : Success if return 0
+ *		  Error if return (< 0), e.g. the output does not fit in dst
+ */
+int lz4_compress(const unsigned char *src, size_t src_len,
+		 unsigned char *dst, size_t *dst_len, void *wrkmem);
+
+/*
+ * lz4hc_compress()
+ *	Same as lz4_compress(), with a slower but stronger match finder.
+ *	wrkmem  : address of the working memory, of LZ4HC_MEM_COMPRESS bytes
+ */
+int lz4hc_compress(const unsigned char *src, size_t src_len,
+		   unsigned char *dst, size_t *dst_len, void *wrkmem);
+
+/*
+ * lz4_decompress_unknownoutputsize()
+ *	src     : source address of the compressed data
+ *	src_len : is the input size, therefore the compressed size
+ *	dest    : output buffer address of the decompressed data
+ *	dest_len: on entry the size of dest, on return the decompressed size
+ *	return  : Success if return 0
+ *		  Error if return (< 0), on malformed input or if the output
+ *		  does not fit in dest
+ *	note :  Never reads or writes beyond the given buffers, so it is
+ *		safe on corrupted input.
+ */
+int lz4_decompress_unknownoutputsize(const unsigned char *src, size_t src_len,
+		unsigned char *dest, size_t *dest_len);
+#endif
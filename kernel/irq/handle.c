@@ -134,6 +134,8 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 {
 	irqreturn_t retval = IRQ_NONE;
 	unsigned int flags = 0, irq = desc->irq_data.irq;
+	u32 softirqs = 0;
+	u64 start = irq_latency_start(&softirqs);
 
 	do {
 		irqreturn_t res;
@@ -172,6 +174,8 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 		action = action->next;
 	} while (action);
 
+	irq_latency_account(desc, start, softirqs);
+
 	add_interrupt_randomness(irq, flags);
 
 	if (!noirqdebug)
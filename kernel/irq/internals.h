@@ -6,6 +6,8 @@
  * of this file for your non core code.
  */
 #include <linux/irqdesc.h>
+#include <linux/interrupt.h>
+#include <linux/sched.h>
 
 #ifdef CONFIG_SPARSE_IRQ
 # define IRQ_BITMAP_BITS	(NR_IRQS + 8196)
@@ -97,6 +99,45 @@ static inline void unregister_handler_proc(unsigned int irq,
 					   struct irqaction *action) { }
 #endif
 
+#ifdef CONFIG_IRQ_LATENCY_HIST
+#define IRQ_LATENCY_BUCKETS	24
+
+struct irq_latency_hist {
+	u32	handler[IRQ_LATENCY_BUCKETS];
+	u32	softirq[IRQ_LATENCY_BUCKETS];
+};
+
+extern u32 irq_latency_enabled;
+
+extern int irq_latency_alloc(struct irq_desc *desc);
+extern void irq_latency_free(struct irq_desc *desc);
+extern void irq_latency_reset(struct irq_desc *desc);
+extern void __irq_latency_account(struct irq_desc *desc, u64 start,
+				  u32 pending);
+
+static inline u64 irq_latency_start(u32 *pending)
+{
+	if (!irq_latency_enabled)
+		return 0;
+	*pending = local_softirq_pending();
+	return local_clock();
+}
+
+static inline void irq_latency_account(struct irq_desc *desc, u64 start,
+				       u32 pending)
+{
+	if (start)
+		__irq_latency_account(desc, start, pending);
+}
+#else
+static inline int irq_latency_alloc(struct irq_desc *desc) { return 0; }
+static inline void irq_latency_free(struct irq_desc *desc) { }
+static inline void irq_latency_reset(struct irq_desc *desc) { }
+static inline u64 irq_latency_start(u32 *pending) { return 0; }
+static inline void irq_latency_account(struct irq_desc *desc, u64 start,
+				       u32 pending) { }
+#endif
+
 extern int irq_select_affinity_usr(unsigned int irq, struct cpumask *mask);
 
 extern void irq_set_thread_affinity(struct irq_desc *desc);
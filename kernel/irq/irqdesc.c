@@ -90,6 +90,7 @@ static void desc_set_defaults(unsigned int irq, struct irq_desc *desc, int node,
 	desc->owner = owner;
 	for_each_possible_cpu(cpu)
 		*per_cpu_ptr(desc->kstat_irqs, cpu) = 0;
+	irq_latency_reset(desc);
 	desc_smp_init(desc, node);
 }
 
@@ -144,9 +145,12 @@ static struct irq_desc *alloc_desc(int irq, int node, struct module *owner)
 	if (!desc->kstat_irqs)
 		goto err_desc;
 
-	if (alloc_masks(desc, gfp, node))
+	if (irq_latency_alloc(desc))
 		goto err_kstat;
 
+	if (alloc_masks(desc, gfp, node))
+		goto err_latency;
+
 	raw_spin_lock_init(&desc->lock);
 	lockdep_set_class(&desc->lock, &irq_desc_lock_class);
 
@@ -154,6 +158,8 @@ static struct irq_desc *alloc_desc(int irq, int node, struct module *owner)
 
 	return desc;
 
+err_latency:
+	irq_latency_free(desc);
 err_kstat:
 	free_percpu(desc->kstat_irqs);
 err_desc:
@@ -172,6 +178,7 @@ static void free_desc(unsigned int irq)
 	mutex_unlock(&sparse_irq_lock);
 
 	free_masks(desc);
+	irq_latency_free(desc);
 	free_percpu(desc->kstat_irqs);
 	kfree(desc);
 }
@@ -262,6 +269,7 @@ int __init early_irq_init(void)
 
 	for (i = 0; i < count; i++) {
 		desc[i].kstat_irqs = alloc_percpu(unsigned int);
+		irq_latency_alloc(&desc[i]);
 		alloc_masks(&desc[i], GFP_KERNEL, node);
 		raw_spin_lock_init(&desc[i].lock);
 		lockdep_set_class(&desc[i].lock, &irq_desc_lock_class);
@@ -0,0 +1,218 @@
+/*
+ * Per-IRQ latency histograms
+ *
+ * Records, for every interrupt line, how long its hard interrupt
+ * handlers ran and how long it took from the end of the hard interrupt
+ * until softirq processing started on the same CPU, when the handler
+ * raised a softirq (NAPI, tasklets, ...). Both are accounted into log2
+ * nanosecond histograms kept per CPU and only ever written by their
+ * own CPU with interrupts disabled, so no locking is needed.
+ *
+ * Accounting is off by default and is switched on through
+ * /sys/kernel/debug/irq_latency/enable.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+
+#include "internals.h"
+
+u32 irq_latency_enabled __read_mostly;
+
+struct irq_latency_pending {
+	unsigned int	irq;
+	u64		stamp;
+};
+
+static DEFINE_PER_CPU(struct irq_latency_pending, irq_latency_pending);
+
+static inline unsigned int irq_latency_bucket(u64 ns)
+{
+	unsigned int b = fls64(ns);
+
+	return min_t(unsigned int, b, IRQ_LATENCY_BUCKETS - 1);
+}
+
+int irq_latency_alloc(struct irq_desc *desc)
+{
+	desc->latency = alloc_percpu(struct irq_latency_hist);
+
+	return desc->latency ? 0 : -ENOMEM;
+}
+
+void irq_latency_free(struct irq_desc *desc)
+{
+	free_percpu(desc->latency);
+	desc->latency = NULL;
+}
+
+void irq_latency_reset(struct irq_desc *desc)
+{
+	int cpu;
+
+	if (!desc->latency)
+		return;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(desc->latency, cpu), 0,
+		       sizeof(struct irq_latency_hist));
+}
+
+/*
+ * Called at the end of handle_irq_event_percpu() with interrupts
+ * disabled. @pending is the softirq mask before the handlers ran, so
+ * that only softirqs raised by this interrupt start the softirq clock.
+ */
+void __irq_latency_account(struct irq_desc *desc, u64 start, u32 pending)
+{
+	struct irq_latency_pending *p;
+	u64 now = local_clock();
+
+	if (!desc->latency)
+		return;
+
+	__this_cpu_inc(desc->latency->handler[irq_latency_bucket(now - start)]);
+
+	if (!(local_softirq_pending() & ~pending))
+		return;
+
+	/* the first interrupt to raise a softirq owns the measurement */
+	p = &__get_cpu_var(irq_latency_pending);
+	if (!p->stamp) {
+		p->irq = desc->irq_data.irq;
+		p->stamp = now;
+	}
+}
+
+/**
+ * irq_latency_softirq_entry - account the hardirq to softirq latency
+ *
+ * Called from __do_softirq() before the pending mask is handled, with
+ * interrupts still disabled.
+ */
+void irq_latency_softirq_entry(void)
+{
+	struct irq_latency_pending *p = &__get_cpu_var(irq_latency_pending);
+	struct irq_desc *desc;
+
+	if (!p->stamp)
+		return;
+
+	desc = irq_to_desc(p->irq);
+	if (desc && desc->latency)
+		__this_cpu_inc(desc->latency->softirq[
+			irq_latency_bucket(local_clock() - p->stamp)]);
+
+	p->stamp = 0;
+}
+
+static void irq_latency_show_hist(struct seq_file *m, const char *what,
+				  struct irq_desc *desc, size_t offset)
+{
+	u32 sum[IRQ_LATENCY_BUCKETS] = { 0 };
+	int cpu, i, last = -1;
+
+	for_each_possible_cpu(cpu) {
+		u32 *hist = (void *)per_cpu_ptr(desc->latency, cpu) + offset;
+
+		for (i = 0; i < IRQ_LATENCY_BUCKETS; i++)
+			sum[i] += hist[i];
+	}
+
+	for (i = 0; i < IRQ_LATENCY_BUCKETS; i++)
+		if (sum[i])
+			last = i;
+	if (last < 0)
+		return;
+
+	seq_printf(m, "  %-8s", what);
+	for (i = 0; i <= last; i++)
+		seq_printf(m, " %u", sum[i]);
+	seq_putc(m, '\n');
+}
+
+static int irq_latency_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc;
+	unsigned long flags;
+	int i;
+
+	seq_puts(m, "bucket n counts events that took [2^(n-1), 2^n) ns,\n");
+	seq_printf(m, "the last bucket (%d) everything above\n",
+		   IRQ_LATENCY_BUCKETS - 1);
+
+	for (i = 0; i < nr_irqs; i++) {
+		desc = irq_to_desc(i);
+		if (!desc)
+			continue;
+
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		if (desc->action && desc->latency) {
+			seq_printf(m, "%d: %s\n", i, desc->action->name ?
+				   desc->action->name : "");
+			irq_latency_show_hist(m, "handler", desc,
+				offsetof(struct irq_latency_hist, handler));
+			irq_latency_show_hist(m, "softirq", desc,
+				offsetof(struct irq_latency_hist, softirq));
+		}
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+	}
+
+	return 0;
+}
+
+static int irq_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_latency_show, NULL);
+}
+
+static ssize_t irq_latency_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct irq_desc *desc;
+	unsigned long flags;
+	int i;
+
+	/* any write clears all histograms */
+	for (i = 0; i < nr_irqs; i++) {
+		desc = irq_to_desc(i);
+		if (!desc)
+			continue;
+
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		irq_latency_reset(desc);
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+	}
+
+	return count;
+}
+
+static const struct file_operations irq_latency_fops = {
+	.open		= irq_latency_open,
+	.read		= seq_read,
+	.write		= irq_latency_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init irq_latency_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("irq_latency", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_bool("enable", S_IRUGO | S_IWUSR, dir,
+			    &irq_latency_enabled);
+	debugfs_create_file("histograms", S_IRUGO | S_IWUSR, dir, NULL,
+			    &irq_latency_fops);
+
+	return 0;
+}
+late_initcall(irq_latency_init);
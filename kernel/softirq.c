@@ -228,6 +228,7 @@ asmlinkage void __do_softirq(void)
 
 	pending = local_softirq_pending();
 	account_irq_enter_time(current);
+	irq_latency_softirq_entry();
 
 	__local_bh_disable((unsigned long)__builtin_return_address(0),
 				SOFTIRQ_OFFSET);
@@ -0,0 +1,86 @@
+/*
+ * LZ4 - fast LZ compressor
+ *
+ * Implements the LZ4 block format designed by Yann Collet, see
+ * http://code.google.com/p/lz4/ for the format description.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/lz4.h>
+#include "lz4defs.h"
+
+#define HASH_LOG	12
+#define HASH_SIZE	(1 << HASH_LOG)
+
+/* Skip faster over data which does not compress */
+#define SKIP_STRENGTH	6
+
+int lz4_compress(const unsigned char *src, size_t src_len,
+		 unsigned char *dst, size_t *dst_len, void *wrkmem)
+{
+	u32 *hash_table = wrkmem;
+	const u8 *ip = src, *anchor = src;
+	const u8 *const iend = src + src_len;
+	const u8 *const mflimit = iend - MFLIMIT;
+	const u8 *const matchlimit = iend - LASTLITERALS;
+	u8 *op = dst;
+	u8 *const oend = dst + *dst_len;
+
+	if (src_len < MIN_LENGTH)
+		goto last_literals;
+
+	memset(hash_table, 0, HASH_SIZE * sizeof(u32));
+
+	while (ip < mflimit) {
+		u32 h = LZ4_HASH(ip, HASH_LOG);
+		const u8 *ref = src + hash_table[h];
+		size_t match_len;
+
+		hash_table[h] = ip - src;
+
+		if (ref >= ip || ip - ref > MAX_DISTANCE ||
+		    LZ4_READ32(ref) != LZ4_READ32(ip)) {
+			ip += 1 + ((ip - anchor) >> SKIP_STRENGTH);
+			continue;
+		}
+
+		/* extend the match backwards over pending literals */
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+
+		match_len = MINMATCH + lz4_count(ip + MINMATCH, ref + MINMATCH,
+						 matchlimit);
+
+		op = lz4_emit(op, oend, anchor, ip - anchor, ip - ref,
+			      match_len);
+		if (!op)
+			return -1;
+
+		ip += match_len;
+		anchor = ip;
+
+		/* index the end of the match for the next search */
+		if (ip < mflimit)
+			hash_table[LZ4_HASH(ip - 2, HASH_LOG)] = ip - 2 - src;
+	}
+
+last_literals:
+	op = lz4_emit(op, oend, anchor, iend - anchor, 0, 0);
+	if (!op)
+		return -1;
+
+	*dst_len = op - dst;
+	return 0;
+}
+EXPORT_SYMBOL(lz4_compress);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 compressor");
@@ -0,0 +1,97 @@
+/*
+ * LZ4 decompressor
+ *
+ * Implements the LZ4 block format designed by Yann Collet, see
+ * http://code.google.com/p/lz4/ for the format description. Every length
+ * and offset read from the input is checked against the buffers, so
+ * corrupted input can not make it read or write out of bounds.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/lz4.h>
+#include "lz4defs.h"
+
+/* Read a length continued in 255-valued bytes, 0 on input overrun */
+static inline int lz4_read_len(const u8 **ip, const u8 *iend, size_t *len)
+{
+	unsigned int s;
+
+	do {
+		if (*ip >= iend)
+			return 0;
+		s = *(*ip)++;
+		*len += s;
+	} while (s == 255);
+
+	return 1;
+}
+
+int lz4_decompress_unknownoutputsize(const unsigned char *src, size_t src_len,
+		unsigned char *dest, size_t *dest_len)
+{
+	const u8 *ip = src;
+	const u8 *const iend = src + src_len;
+	u8 *op = dest;
+	u8 *const oend = dest + *dest_len;
+
+	while (ip < iend) {
+		unsigned int token = *ip++;
+		size_t len = token >> ML_BITS;
+		size_t offset;
+		const u8 *ref;
+
+		/* literals */
+		if (len == RUN_MASK && !lz4_read_len(&ip, iend, &len))
+			return -1;
+		if (len > iend - ip || len > oend - op)
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* the last sequence has no match part */
+		if (ip == iend)
+			break;
+
+		/* match */
+		if (iend - ip < 2)
+			return -1;
+		offset = get_unaligned_le16(ip);
+		ip += 2;
+		if (!offset || offset > op - dest)
+			return -1;
+		ref = op - offset;
+
+		len = token & ML_MASK;
+		if (len == ML_MASK && !lz4_read_len(&ip, iend, &len))
+			return -1;
+		len += MINMATCH;
+		if (len > oend - op)
+			return -1;
+
+		/* the match may overlap the output, copy forward */
+		if (offset >= COPYLENGTH) {
+			while (len >= COPYLENGTH) {
+				memcpy(op, ref, COPYLENGTH);
+				op += COPYLENGTH;
+				ref += COPYLENGTH;
+				len -= COPYLENGTH;
+			}
+		}
+		while (len--)
+			*op++ = *ref++;
+	}
+
+	*dest_len = op - dest;
+	return 0;
+}
+EXPORT_SYMBOL(lz4_decompress_unknownoutputsize);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 Decompressor");
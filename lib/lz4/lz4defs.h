@@ -0,0 +1,98 @@
+/*
+ * lz4defs.h -- definitions shared by the LZ4 compressors and decompressor
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/unaligned.h>
+
+#define COPYLENGTH	8
+#define MINMATCH	4
+#define LASTLITERALS	5
+#define MFLIMIT		(COPYLENGTH + MINMATCH)
+#define MIN_LENGTH	(MFLIMIT + 1)
+
+#define ML_BITS		4
+#define ML_MASK		((1U << ML_BITS) - 1)
+#define RUN_BITS	(8 - ML_BITS)
+#define RUN_MASK	((1U << RUN_BITS) - 1)
+
+#define MAXD_LOG	16
+#define MAX_DISTANCE	((1 << MAXD_LOG) - 1)
+
+#define LZ4_READ32(p)	get_unaligned((const u32 *)(p))
+
+/* Knuth's multiplicative hash of the next MINMATCH bytes */
+#define LZ4_HASH(p, bits) \
+	((LZ4_READ32(p) * 2654435761U) >> (32 - (bits)))
+
+/*
+ * Length of the common prefix of @p and @ref, not looking at @limit and
+ * beyond.
+ */
+static inline unsigned int lz4_count(const u8 *p, const u8 *ref,
+				     const u8 *limit)
+{
+	const u8 *start = p;
+
+	while (p + 4 <= limit && LZ4_READ32(p) == LZ4_READ32(ref)) {
+		p += 4;
+		ref += 4;
+	}
+	while (p < limit && *p == *ref) {
+		p++;
+		ref++;
+	}
+
+	return p - start;
+}
+
+/*
+ * Emit one sequence: @lit_len literals from @anchor followed by a match of
+ * @match_len bytes at @offset. A @match_len of zero emits the closing
+ * literals-only sequence. Returns the new output position, or NULL if the
+ * sequence does not fit before @oend.
+ */
+static inline u8 *lz4_emit(u8 *op, u8 *oend, const u8 *anchor,
+			   size_t lit_len, unsigned int offset,
+			   size_t match_len)
+{
+	u8 *token = op++;
+	size_t len;
+
+	/* worst case: length bytes + literals + offset + match length bytes */
+	if (op + lit_len + lit_len / 255 + 1 + 2 + match_len / 255 + 1 > oend)
+		return NULL;
+
+	if (lit_len >= RUN_MASK) {
+		*token = RUN_MASK << ML_BITS;
+		for (len = lit_len - RUN_MASK; len >= 255; len -= 255)
+			*op++ = 255;
+		*op++ = len;
+	} else {
+		*token = lit_len << ML_BITS;
+	}
+
+	memcpy(op, anchor, lit_len);
+	op += lit_len;
+
+	if (!match_len)
+		return op;
+
+	put_unaligned_le16(offset, op);
+	op += 2;
+
+	len = match_len - MINMATCH;
+	if (len >= ML_MASK) {
+		*token |= ML_MASK;
+		for (len -= ML_MASK; len >= 255; len -= 255)
+			*op++ = 255;
+		*op++ = len;
+	} else {
+		*token |= len;
+	}
+
+	return op;
+}
@@ -0,0 +1,153 @@
+/*
+ * LZ4 HC - high compression LZ4 compressor
+ *
+ * Implements the LZ4 block format designed by Yann Collet, see
+ * http://code.google.com/p/lz4/ for the format description. The output is
+ * decoded by the regular LZ4 decompressor; only the match finder differs,
+ * using hash chains over the whole 64KB window instead of a single hash
+ * table probe.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/lz4.h>
+#include "lz4defs.h"
+
+#define HASH_LOG	15
+#define HASH_SIZE	(1 << HASH_LOG)
+#define MAX_ATTEMPTS	256
+
+/*
+ * Positions are stored biased by 64KB in @hash_table, so that an empty
+ * (zeroed) slot is always out of the window.
+ */
+#define POS_BIAS	(MAX_DISTANCE + 1)
+
+struct lz4hc_data {
+	u32 hash_table[HASH_SIZE];
+	u16 chain_table[MAX_DISTANCE + 1];
+};
+
+struct lz4hc_ctx {
+	struct lz4hc_data *data;
+	const u8 *base;
+	u32 next_to_update;
+};
+
+/* Index all positions up to, but not including, @ip */
+static void lz4hc_insert(struct lz4hc_ctx *ctx, const u8 *ip)
+{
+	struct lz4hc_data *data = ctx->data;
+	u32 target = ip - ctx->base;
+
+	while (ctx->next_to_update < target) {
+		u32 pos = ctx->next_to_update++;
+		u32 h = LZ4_HASH(ctx->base + pos, HASH_LOG);
+		u32 delta = pos + POS_BIAS - data->hash_table[h];
+
+		if (delta > MAX_DISTANCE)
+			delta = MAX_DISTANCE;
+		data->chain_table[pos & MAX_DISTANCE] = delta;
+		data->hash_table[h] = pos + POS_BIAS;
+	}
+}
+
+/* Find the longest match for @ip, returns its length or 0 */
+static size_t lz4hc_find_match(struct lz4hc_ctx *ctx, const u8 *ip,
+			       const u8 *matchlimit, const u8 **match)
+{
+	struct lz4hc_data *data = ctx->data;
+	s64 pos = ip - ctx->base;
+	s64 ref;
+	size_t best = 0;
+	int attempts = MAX_ATTEMPTS;
+
+	lz4hc_insert(ctx, ip);
+	ref = (s64)data->hash_table[LZ4_HASH(ip, HASH_LOG)] - POS_BIAS;
+
+	while (ref >= 0 && pos - ref <= MAX_DISTANCE && attempts--) {
+		const u8 *r = ctx->base + ref;
+
+		if (r[best] == ip[best] && LZ4_READ32(r) == LZ4_READ32(ip)) {
+			size_t len = MINMATCH + lz4_count(ip + MINMATCH,
+							  r + MINMATCH,
+							  matchlimit);
+
+			if (len > best) {
+				best = len;
+				*match = r;
+			}
+		}
+		ref -= data->chain_table[ref & MAX_DISTANCE];
+	}
+
+	return best;
+}
+
+int lz4hc_compress(const unsigned char *src, size_t src_len,
+		   unsigned char *dst, size_t *dst_len, void *wrkmem)
+{
+	struct lz4hc_ctx ctx;
+	const u8 *ip = src, *anchor = src;
+	const u8 *const iend = src + src_len;
+	const u8 *const mflimit = iend - MFLIMIT;
+	const u8 *const matchlimit = iend - LASTLITERALS;
+	u8 *op = dst;
+	u8 *const oend = dst + *dst_len;
+
+	BUILD_BUG_ON(sizeof(struct lz4hc_data) > LZ4HC_MEM_COMPRESS);
+
+	if (src_len < MIN_LENGTH)
+		goto last_literals;
+
+	ctx.data = wrkmem;
+	ctx.base = src;
+	ctx.next_to_update = 0;
+	memset(ctx.data->hash_table, 0, sizeof(ctx.data->hash_table));
+
+	while (ip < mflimit) {
+		const u8 *ref = NULL, *ref2 = NULL;
+		size_t len, len2;
+
+		len = lz4hc_find_match(&ctx, ip, matchlimit, &ref);
+		if (!len) {
+			ip++;
+			continue;
+		}
+
+		/* lazy matching: prefer a longer match starting one later */
+		while (ip + 1 < mflimit) {
+			len2 = lz4hc_find_match(&ctx, ip + 1, matchlimit,
+						&ref2);
+			if (len2 <= len)
+				break;
+			ip++;
+			len = len2;
+			ref = ref2;
+		}
+
+		op = lz4_emit(op, oend, anchor, ip - anchor, ip - ref, len);
+		if (!op)
+			return -1;
+
+		ip += len;
+		anchor = ip;
+	}
+
+last_literals:
+	op = lz4_emit(op, oend, anchor, iend - anchor, 0, 0);
+	if (!op)
+		return -1;
+
+	*dst_len = op - dst;
+	return 0;
+}
+EXPORT_SYMBOL(lz4hc_compress);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4HC compressor");
@@ -31,6 +31,7 @@
 #include <linux/hugetlb.h>
 #include <linux/hugetlb_cgroup.h>
 #include <linux/node.h>
+#include <linux/dma_page_offload.h>
 #include "internal.h"
 
 const unsigned long hugetlb_zero = 0, hugetlb_infinity = ~0UL;
@@ -500,6 +501,9 @@ void copy_huge_page(struct page *dst, struct page *src)
 	}
 
 	might_sleep();
+	if (!dma_offload_copy_pages(dst, src, pages_per_huge_page(h)))
+		return;
+
 	for (i = 0; i < pages_per_huge_page(h); i++) {
 		cond_resched();
 		copy_highpage(dst + i, src + i);
@@ -59,6 +59,7 @@
 #include <linux/gfp.h>
 #include <linux/migrate.h>
 #include <linux/string.h>
+#include <linux/dma_page_offload.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -4284,6 +4285,9 @@ void clear_huge_page(struct page *page,
 	}
 
 	might_sleep();
+	if (!dma_offload_clear_pages(page, pages_per_huge_page))
+		return;
+
 	for (i = 0; i < pages_per_huge_page; i++) {
 		cond_resched();
 		clear_user_highpage(page + i, addr + i * PAGE_SIZE);
@@ -4322,6 +4326,9 @@ void copy_user_huge_page(struct page *dst, struct page *src,
 	}
 
 	might_sleep();
+	if (!dma_offload_copy_pages(dst, src, pages_per_huge_page))
+		return;
+
 	for (i = 0; i < pages_per_huge_page; i++) {
 		cond_resched();
 		copy_user_highpage(dst + i, src + i, addr + i*PAGE_SIZE, vma);
@@ -36,6 +36,7 @@
 #include <linux/hugetlb_cgroup.h>
 #include <linux/gfp.h>
 #include <linux/balloon_compaction.h>
+#include <linux/dma_page_offload.h>
 
 #include <asm/tlbflush.h>
 
@@ -441,7 +442,7 @@ void migrate_page_copy(struct page *newpage, struct page *page)
 {
 	if (PageHuge(page) || PageTransHuge(page))
 		copy_huge_page(newpage, page);
-	else
+	else if (dma_offload_copy_pages(newpage, page, 1))
 		copy_highpage(newpage, page);
 
 	if (PageError(page))
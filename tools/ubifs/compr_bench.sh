@@ -0,0 +1,100 @@
+#!/bin/sh
+#
+# Compare UBIFS read and write throughput across compressors on NANDSIM.
+#
+# For every compressor given on the command line (default: none lzo zlib
+# lz4), a fresh UBIFS is created on a simulated NAND, mounted with
+# "compr=<compressor>", and a data set is written to it, synced, read back
+# with the page cache dropped, and compared. The data set is a copy of
+# SRC (default: /usr/bin), so that it compresses like real files do.
+#
+# Needs root, the nandsim, ubi and ubifs modules, and ubiattach/ubimkvol
+# from mtd-utils. Sizes can be tuned with the environment variables below.
+#
+# Usage: compr_bench.sh [compressor...]
+
+SRC=${SRC:-/usr/bin}
+MNT=${MNT:-/mnt/ubifs-bench}
+# 256MiB, 2KiB page, 128KiB eraseblock
+NANDSIM_ID=${NANDSIM_ID:-"first_id_byte=0x20 second_id_byte=0xaa third_id_byte=0x00 fourth_id_byte=0x15"}
+VOL_SIZE=${VOL_SIZE:-200MiB}
+
+COMPRS=${*:-"none lzo zlib lz4"}
+
+die()
+{
+	echo "$@" >&2
+	cleanup
+	exit 1
+}
+
+cleanup()
+{
+	umount $MNT 2>/dev/null
+	ubidetach -p /dev/mtd0 2>/dev/null
+	rmmod ubifs ubi nandsim 2>/dev/null
+}
+
+now_ms()
+{
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# throughput in KiB/s: bytes, milliseconds
+rate()
+{
+	[ $2 -gt 0 ] || { echo "-"; return; }
+	echo $(($1 * 1000 / 1024 / $2))
+}
+
+[ $(id -u) -eq 0 ] || die "must be run as root"
+[ -d "$SRC" ] || die "source directory $SRC does not exist"
+
+mkdir -p $MNT
+rm -f $MNT.stats
+cleanup
+
+bytes=$(du -sb "$SRC" | cut -f1)
+printf "data set: %s, %d KiB\n\n" "$SRC" $((bytes / 1024))
+printf "%-6s %10s %12s %12s %8s\n" "compr" "used KiB" "write KiB/s" \
+	"read KiB/s" "ratio"
+
+for compr in $COMPRS; do
+	modprobe nandsim $NANDSIM_ID || die "cannot load nandsim"
+	modprobe ubi || die "cannot load ubi"
+	ubiattach -p /dev/mtd0 >/dev/null || die "cannot attach UBI"
+	ubimkvol /dev/ubi0 -N bench -s $VOL_SIZE >/dev/null ||
+		die "cannot create volume"
+	modprobe ubifs || die "cannot load ubifs"
+	mount -t ubifs -o compr=$compr ubi0:bench $MNT ||
+		die "cannot mount with compr=$compr"
+
+	start=$(now_ms)
+	cp -a "$SRC" $MNT/data || die "write failed"
+	sync
+	wtime=$(($(now_ms) - start))
+	used=$(df -k $MNT | awk 'NR == 2 { print $3 }')
+
+	echo 3 > /proc/sys/vm/drop_caches
+	start=$(now_ms)
+	find $MNT/data -type f -exec cat {} + > /dev/null
+	rtime=$(($(now_ms) - start))
+
+	diff -r "$SRC" $MNT/data >/dev/null || die "data mismatch with $compr"
+
+	printf "%-6s %10d %12s %12s %8s\n" $compr $used \
+		$(rate $bytes $wtime) $(rate $bytes $rtime) \
+		$(awk "BEGIN { printf \"%.2f\", $bytes / 1024 / ($used ? $used : 1) }")
+
+	# compressor counters go away with the module, keep them per run
+	[ -f /sys/kernel/debug/ubifs/compr_stats ] &&
+		grep -A2 "^$compr:" /sys/kernel/debug/ubifs/compr_stats >> $MNT.stats
+
+	cleanup
+done
+
+if [ -s $MNT.stats ]; then
+	echo
+	cat $MNT.stats
+fi
+rm -f $MNT.stats